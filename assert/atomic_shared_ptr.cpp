@@ -0,0 +1,60 @@
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "atomic_shared_ptr.hpp"
+
+using namespace std;
+
+class Config
+{
+public:
+    int version;
+    Config(int v) : version(v) { std::cout << "Config " << version << " acquired\n"; }
+    ~Config() { std::cout << "Config " << version << " destoryed\n"; }
+};
+
+atomic_shared_ptr<Config> current(make_shared<Config>(1));
+
+int main()
+{
+    cout << "lock free: " << current.is_lock_free() << endl;
+
+    // a reader keeps the snapshot it loaded, even after it is replaced
+    shared_ptr<Config> mine = current.load();
+    current.store(make_shared<Config>(2));
+    cout << "still using version " << mine->version << ", current is " << current.load()->version << endl;
+    cout << "Killing the old snapshot" << endl;
+    mine.reset();
+
+    // only replace what we looked at; the second try sees version 3 and fails
+    shared_ptr<Config> seen = current.load();
+    bool replaced = current.compare_exchange_strong(seen, make_shared<Config>(3));
+    cout << "2 -> 3: " << replaced << endl;
+    replaced = current.compare_exchange_strong(seen, make_shared<Config>(4));
+    cout << "2 -> 4: " << replaced << ", current is " << seen->version << endl;
+    seen.reset();
+
+    // threads reading while one thread publishes
+    atomic_shared_ptr<vector<int>> numbers(make_shared<vector<int>>(100, 0));
+    vector<thread> readers;
+    long sums[4] = {};
+    for (int t = 0; t < 4; t++)
+        readers.emplace_back([&, t] {
+            for (int i = 0; i < 10000; i++)
+            {
+                auto snapshot = numbers.load();
+                sums[t] += snapshot->front() - snapshot->back(); // always 0, a snapshot never changes
+            }
+        });
+    for (int i = 1; i <= 1000; i++)
+        numbers.store(make_shared<vector<int>>(100, i));
+    for (thread &reader : readers)
+        reader.join();
+    cout << "readers saw torn snapshots: " << (sums[0] | sums[1] | sums[2] | sums[3]) << endl;
+
+    cout << "Killing the last config" << endl;
+    current.store(nullptr);
+    return 0;
+}
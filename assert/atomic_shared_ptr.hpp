@@ -0,0 +1,188 @@
+#ifndef ATOMIC_SHARED_PTR_H_
+#define ATOMIC_SHARED_PTR_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// A std::shared_ptr that threads can load and replace at the same time
+// without a lock, for a value many threads read and one now and then
+// replaces, like a configuration:
+//     atomic_shared_ptr<Config> current(make_shared<Config>(...));
+//     shared_ptr<Config> config = current.load();  // readers
+//     current.store(make_shared<Config>(...));     // writer
+// std::atomic_load on a shared_ptr does the same, but common libraries
+// implement it with a small table of global mutexes, so all readers fight
+// over the same locks.
+//
+// Split reference count: the shared_ptr lives in a Node, and the pointer to
+// the Node shares one 64 bit word with a count of readers using it.
+//   load     adds 1 to the count and gets the Node in the same atomic step,
+//            so the Node can't be freed under it, copies the shared_ptr, then
+//            takes the 1 back from the count; if a store replaced the Node
+//            meanwhile, it takes it from the Node's own count instead
+//   store    swaps in a new Node and moves the readers still counted in the
+//            word to the old Node's own count; whoever brings that to 0
+//            frees the Node
+// The count has 16 bits, so at most 65535 threads may be inside load() at
+// once, and pointers must fit in 48 bits, which they do in user space on
+// x86-64 and AArch64.
+template <class T>
+class atomic_shared_ptr
+{
+private:
+    struct Node
+    {
+        std::shared_ptr<T> value;
+        std::atomic<long> refs{0}; // readers released here minus readers handed over by store, 0 frees the Node
+
+        explicit Node(std::shared_ptr<T> v) : value(std::move(v)) {}
+    };
+
+    static constexpr int count_shift = 48;
+    static constexpr uint64_t one_reader = uint64_t(1) << count_shift;
+    static constexpr uint64_t pointer_mask = one_reader - 1;
+
+    static_assert(sizeof(void *) == 8, "the Node pointer and the count share 64 bits");
+
+    mutable std::atomic<uint64_t> word_{0};
+
+    static Node *node_of(uint64_t word) { return reinterpret_cast<Node *>(word & pointer_mask); }
+    static long readers_of(uint64_t word) { return long(word >> count_shift); }
+
+    // an empty shared_ptr with no control block is stored as no Node at all
+    static uint64_t make_word(std::shared_ptr<T> p)
+    {
+        if (!p && p.use_count() == 0)
+            return 0;
+        uint64_t word = reinterpret_cast<uint64_t>(new Node(std::move(p)));
+        assert((word & ~pointer_mask) == 0);
+        return word;
+    }
+
+    // count one more reader of the current Node
+    Node *acquire() const
+    {
+        return node_of(word_.fetch_add(one_reader, std::memory_order_acquire));
+    }
+
+    // undo acquire()
+    void release(Node *node) const
+    {
+        uint64_t word = word_.load(std::memory_order_relaxed);
+        while (node_of(word) == node)
+            if (word_.compare_exchange_weak(word, word - one_reader, std::memory_order_release, std::memory_order_relaxed))
+                return;
+        // replaced; the store that did it moved our count to the Node
+        if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete node;
+    }
+
+    // the word no longer points at node, readers of them are still counted in it
+    static void retire(Node *node, long readers)
+    {
+        if (node && node->refs.fetch_add(readers, std::memory_order_acq_rel) == -readers)
+            delete node;
+    }
+
+    static bool same(const std::shared_ptr<T> &a, const std::shared_ptr<T> &b)
+    {
+        return a == b && !a.owner_before(b) && !b.owner_before(a);
+    }
+
+public:
+    atomic_shared_ptr() noexcept = default;
+    atomic_shared_ptr(std::shared_ptr<T> p) : word_(make_word(std::move(p))) {}
+    atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+    atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+    ~atomic_shared_ptr() { retire(node_of(word_.load(std::memory_order_acquire)), 0); }
+
+    bool is_lock_free() const noexcept { return word_.is_lock_free(); }
+
+    std::shared_ptr<T> load() const
+    {
+        Node *node = acquire();
+        if (!node)
+        {
+            release(node);
+            return std::shared_ptr<T>();
+        }
+        std::shared_ptr<T> value = node->value;
+        release(node);
+        return value;
+    }
+
+    void store(std::shared_ptr<T> p)
+    {
+        uint64_t old = word_.exchange(make_word(std::move(p)), std::memory_order_acq_rel);
+        retire(node_of(old), readers_of(old));
+    }
+
+    std::shared_ptr<T> exchange(std::shared_ptr<T> p)
+    {
+        uint64_t old = word_.exchange(make_word(std::move(p)), std::memory_order_acq_rel);
+        Node *node = node_of(old);
+        // copied, not moved: readers counted in old may still be copying it
+        std::shared_ptr<T> value = node ? node->value : std::shared_ptr<T>();
+        retire(node, readers_of(old));
+        return value;
+    }
+
+    // Replaces the value with desired if it is expected (same pointer and
+    // same owner), otherwise puts the current value into expected.
+    bool compare_exchange_strong(std::shared_ptr<T> &expected, std::shared_ptr<T> desired)
+    {
+        uint64_t fresh = make_word(std::move(desired));
+        for (;;)
+        {
+            Node *node = acquire();
+            std::shared_ptr<T> current = node ? node->value : std::shared_ptr<T>();
+            if (!same(current, expected))
+            {
+                release(node);
+                expected = std::move(current);
+                retire(node_of(fresh), 0);
+                return false;
+            }
+            uint64_t word = word_.load(std::memory_order_relaxed);
+            while (node_of(word) == node)
+                if (word_.compare_exchange_weak(word, fresh, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    retire(node, readers_of(word) - 1); // minus our own acquire()
+                    return true;
+                }
+            release(node); // replaced under us, look at the new value
+        }
+    }
+
+    // like compare_exchange_strong, but gives up with false when another
+    // thread changes the value at the same time
+    bool compare_exchange_weak(std::shared_ptr<T> &expected, std::shared_ptr<T> desired)
+    {
+        uint64_t fresh = make_word(std::move(desired));
+        Node *node = acquire();
+        std::shared_ptr<T> current = node ? node->value : std::shared_ptr<T>();
+        uint64_t word = word_.load(std::memory_order_relaxed);
+        if (same(current, expected) && node_of(word) == node &&
+            word_.compare_exchange_strong(word, fresh, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            retire(node, readers_of(word) - 1);
+            return true;
+        }
+        release(node);
+        expected = std::move(current);
+        retire(node_of(fresh), 0);
+        return false;
+    }
+
+    operator std::shared_ptr<T>() const { return load(); }
+    atomic_shared_ptr &operator=(std::shared_ptr<T> p)
+    {
+        store(std::move(p));
+        return *this;
+    }
+};
+
+#endif
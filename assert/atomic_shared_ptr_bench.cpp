@@ -0,0 +1,110 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "atomic_shared_ptr.hpp"
+
+using namespace std;
+
+// a configuration snapshot; check lets readers see whether they got a torn one
+struct Config
+{
+    long version;
+    long check;
+    explicit Config(long v) : version(v), check(-v) {}
+};
+
+// std::atomic_load and std::atomic_store on a plain shared_ptr
+struct StdAtomic
+{
+    shared_ptr<Config> p = make_shared<Config>(0);
+    shared_ptr<Config> load() { return atomic_load(&p); }
+    void store(shared_ptr<Config> c) { atomic_store(&p, std::move(c)); }
+};
+
+// a mutex around a shared_ptr
+struct Locked
+{
+    mutex m;
+    shared_ptr<Config> p = make_shared<Config>(0);
+    shared_ptr<Config> load()
+    {
+        lock_guard<mutex> lock(m);
+        return p;
+    }
+    void store(shared_ptr<Config> c)
+    {
+        lock_guard<mutex> lock(m);
+        p = std::move(c);
+    }
+};
+
+struct LockFree
+{
+    atomic_shared_ptr<Config> p{make_shared<Config>(0)};
+    shared_ptr<Config> load() { return p.load(); }
+    void store(shared_ptr<Config> c) { p.store(std::move(c)); }
+};
+
+// one writer publishing a new Config every 50 us, readers loading as fast as they can
+template <class Holder>
+void run(const char *name, int readers)
+{
+    Holder holder;
+    atomic<bool> stop{false};
+    vector<long> loads(readers * 16); // 16 apart, so readers don't share a cache line
+    atomic<long> torn{0};
+
+    vector<thread> threads;
+    for (int r = 0; r < readers; r++)
+        threads.emplace_back([&, r] {
+            long n = 0, bad = 0;
+            while (!stop.load(memory_order_relaxed))
+            {
+                shared_ptr<Config> c = holder.load();
+                bad += c->version + c->check != 0;
+                n++;
+            }
+            loads[r * 16] = n;
+            torn += bad;
+        });
+
+    long writes = 0;
+    auto begin = chrono::steady_clock::now();
+    auto end = begin + chrono::milliseconds(500);
+    while (chrono::steady_clock::now() < end)
+    {
+        holder.store(make_shared<Config>(++writes));
+        this_thread::sleep_for(chrono::microseconds(50));
+    }
+    stop = true;
+    for (thread &t : threads)
+        t.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+    long total = 0;
+    for (int r = 0; r < readers; r++)
+        total += loads[r * 16];
+    cout << name << ": " << total / seconds / 1e6 << " M loads/s, " << writes << " stores, "
+         << torn << " torn" << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    int readers = argc > 1 ? atoi(argv[1]) : max(2u, thread::hardware_concurrency());
+    cout << "1 writer, " << readers << " readers, 0.5 s each, " << thread::hardware_concurrency()
+         << " hardware threads" << endl;
+    cout << "atomic_shared_ptr lock free: " << atomic_shared_ptr<Config>().is_lock_free() << endl;
+    for (int round = 0; round < 2; round++)
+    {
+        run<StdAtomic>("std::atomic_load ", readers);
+        run<Locked>("mutex            ", readers);
+        run<LockFree>("atomic_shared_ptr", readers);
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include "circle_batch.hpp"
+
+int main()
+{
+    CircleBatch batch;
+    batch.reserve(4);
+    batch.push_back("red", 1, 0, 0);
+    batch.push_back("blue", 2, 12, 5);
+    batch.push_back("red", 0.5, -3, 4);
+
+    Circle c("green", 3, 1, 1);
+    batch.push_back(c);
+
+    cout << "batch size: " << batch.size() << endl;
+    cout << "color of #3: " << batch.get_color(3) << ", id " << batch.get_color_id(3) << endl;
+    cout << "color of #2: " << batch.get_color(2) << ", id " << batch.get_color_id(2) << endl;
+
+    double squares[4];
+    batch.square_all(squares);
+    for (size_t i = 0; i < batch.size(); i++)
+        cout << "square of #" << i << ": " << squares[i] << endl;
+
+    cout << "scalar all by 2 and move all by (1, -1)...." << endl;
+    batch.scalar_all(2);
+    batch.move_all(1, -1);
+
+    CircleBatch::Box box = batch.bounding_box();
+    cout << "bounding box: (" << box.min_x << ", " << box.min_y << ") - ("
+         << box.max_x << ", " << box.max_y << ")" << endl;
+
+    cout << "an empty batch has an empty box: " << CircleBatch().bounding_box().empty() << endl;
+
+    cout << "convert #1 back to Circle" << endl;
+    Circle c1 = batch.to_circle(1);
+    c1.show();
+
+    return 0;
+}
@@ -0,0 +1,162 @@
+#ifndef CIRCLE_BATCH_H_
+#define CIRCLE_BATCH_H_
+
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "class.hpp"
+
+// Structure-of-arrays container for many circles.
+// Each field lives in its own contiguous array, so the bulk operations below
+// only touch the bytes they need and compile down to plain SIMD loops.
+// Colours are stored as ColorTable ids, the same ones Circle uses.
+class CircleBatch
+{
+private:
+    std::vector<double> rand_;
+    std::vector<double> x_index_;
+    std::vector<double> y_index_;
+    std::vector<unsigned> color_id_;
+
+public:
+    struct Box
+    {
+        double min_x;
+        double min_y;
+        double max_x;
+        double max_y;
+
+        // only the box of an empty batch, where min is above max
+        bool empty() const { return min_x > max_x; }
+    };
+
+    CircleBatch() = default;
+
+    size_t size() const { return rand_.size(); }
+    void reserve(size_t n);
+    void clear();
+
+    // add one circle, same arguments and checks as Circle's constructor
+    void push_back(const string &color, double rand, double x_index, double y_index);
+    void push_back(Circle &c);
+    Circle to_circle(size_t i) const;
+
+    // bulk versions of Circle::square, Circle::scalar and Circle::move_to
+    void square_all(double *out) const;
+    void scalar_all(double scale);
+    void move_all(double dx, double dy); // translate every circle by (dx, dy)
+
+    // smallest box containing every circle. An empty batch gives min = the
+    // largest double and max = the lowest, the box that adds nothing when
+    // merged into another; check with Box::empty().
+    Box bounding_box() const;
+
+    const string &get_color(size_t i) const { return ColorTable::instance().name(color_id_[i]); }
+    unsigned get_color_id(size_t i) const { return color_id_[i]; }
+    double get_rand(size_t i) const { return rand_[i]; }
+    double get_x_index(size_t i) const { return x_index_[i]; }
+    double get_y_index(size_t i) const { return y_index_[i]; }
+
+    // raw arrays for callers that want to run their own kernels
+    const double *rand_data() const { return rand_.data(); }
+    const double *x_index_data() const { return x_index_.data(); }
+    const double *y_index_data() const { return y_index_.data(); }
+};
+
+inline void CircleBatch::reserve(size_t n)
+{
+    rand_.reserve(n);
+    x_index_.reserve(n);
+    y_index_.reserve(n);
+    color_id_.reserve(n);
+}
+
+inline void CircleBatch::clear()
+{
+    rand_.clear();
+    x_index_.clear();
+    y_index_.clear();
+    color_id_.clear();
+}
+
+inline void CircleBatch::push_back(const string &color, double rand, double x_index, double y_index)
+{
+    if(rand < 0)
+        abort();
+    rand_.push_back(rand);
+    x_index_.push_back(x_index);
+    y_index_.push_back(y_index);
+    color_id_.push_back(ColorTable::instance().intern(color));
+}
+
+inline void CircleBatch::push_back(Circle &c)
+{
+    rand_.push_back(c.get_rand());
+    x_index_.push_back(c.get_x_index());
+    y_index_.push_back(c.get_y_index());
+    color_id_.push_back(c.get_color_id());
+}
+
+inline Circle CircleBatch::to_circle(size_t i) const
+{
+    return Circle(get_color(i), rand_[i], x_index_[i], y_index_[i]);
+}
+
+// out must have room for size() results
+inline void CircleBatch::square_all(double *out) const
+{
+    const double *r = rand_.data();
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++)
+        out[i] = PI * r[i] * r[i];
+}
+
+inline void CircleBatch::scalar_all(double scale)
+{
+    if(scale <= 0)
+        return;
+    double *r = rand_.data();
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++)
+        r[i] *= scale;
+}
+
+inline void CircleBatch::move_all(double dx, double dy)
+{
+    double *x = x_index_.data();
+    double *y = y_index_.data();
+    const size_t n = size();
+    for (size_t i = 0; i < n; i++)
+        x[i] += dx;
+    for (size_t i = 0; i < n; i++)
+        y[i] += dy;
+}
+
+inline CircleBatch::Box CircleBatch::bounding_box() const
+{
+    const double *r = rand_.data();
+    const double *x = x_index_.data();
+    const double *y = y_index_.data();
+    const size_t n = size();
+
+    // branch-free min/max reductions, the compiler vectorizes them once -ffast-math allows reordering
+    // not infinity: -ffast-math assumes there are none
+    const double highest = std::numeric_limits<double>::max(), lowest = std::numeric_limits<double>::lowest();
+    double min_x = highest, min_y = highest, max_x = lowest, max_y = lowest;
+    for (size_t i = 0; i < n; i++)
+    {
+        double left = x[i] - r[i];
+        double right = x[i] + r[i];
+        double bottom = y[i] - r[i];
+        double top = y[i] + r[i];
+        min_x = left < min_x ? left : min_x;
+        max_x = right > max_x ? right : max_x;
+        min_y = bottom < min_y ? bottom : min_y;
+        max_y = top > max_y ? top : max_y;
+    }
+    return Box{min_x, min_y, max_x, max_y};
+}
+
+#endif
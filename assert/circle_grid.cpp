@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#define CIRCLE_SILENT // don't print a message for each of the 20000 circles
+#include "circle_grid.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// the brute-force versions we want to replace: look at every circle
+std::vector<unsigned> scan_point(std::vector<Circle> &circles, double x, double y)
+{
+    std::vector<unsigned> result;
+    for (unsigned i = 0; i < circles.size(); i++)
+    {
+        double dx = circles[i].get_x_index() - x, dy = circles[i].get_y_index() - y;
+        if (dx * dx + dy * dy <= circles[i].get_rand() * circles[i].get_rand())
+            result.push_back(i);
+    }
+    return result;
+}
+
+std::vector<unsigned> scan_rect(std::vector<Circle> &circles, double min_x, double min_y, double max_x, double max_y)
+{
+    std::vector<unsigned> result;
+    for (unsigned i = 0; i < circles.size(); i++)
+    {
+        double dx = circles[i].get_x_index() - std::clamp(circles[i].get_x_index(), min_x, max_x);
+        double dy = circles[i].get_y_index() - std::clamp(circles[i].get_y_index(), min_y, max_y);
+        if (dx * dx + dy * dy <= circles[i].get_rand() * circles[i].get_rand())
+            result.push_back(i);
+    }
+    return result;
+}
+
+std::vector<unsigned> scan_nearest(std::vector<Circle> &circles, double x, double y, size_t k)
+{
+    std::vector<std::pair<double, unsigned>> all;
+    for (unsigned i = 0; i < circles.size(); i++)
+    {
+        double d = std::hypot(circles[i].get_x_index() - x, circles[i].get_y_index() - y) - circles[i].get_rand();
+        all.push_back(std::make_pair(d > 0 ? d : 0, i));
+    }
+    std::partial_sort(all.begin(), all.begin() + k, all.end());
+    std::vector<unsigned> result;
+    for (size_t i = 0; i < k; i++)
+        result.push_back(all[i].second);
+    return result;
+}
+
+int main()
+{
+    const unsigned n = 20000, queries = 2000;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> pos(0, 1000), rad(0.5, 3);
+
+    std::vector<Circle> circles;
+    circles.reserve(n);
+    for (unsigned i = 0; i < n; i++)
+        circles.emplace_back("red", rad(gen), pos(gen), pos(gen));
+
+    auto begin = Clock::now();
+    CircleGrid grid(4);
+    grid.build(circles);
+    cout << "build " << n << " circles: " << ms_since(begin) << " ms" << endl;
+
+    std::vector<std::pair<double, double>> points;
+    for (unsigned i = 0; i < queries; i++)
+        points.push_back(std::make_pair(pos(gen), pos(gen)));
+
+    size_t hits = 0, mismatches = 0;
+    begin = Clock::now();
+    for (auto &p : points)
+        hits += scan_point(circles, p.first, p.second).size();
+    cout << "brute-force point queries: " << ms_since(begin) << " ms, " << hits << " hits" << endl;
+
+    hits = 0;
+    begin = Clock::now();
+    for (auto &p : points)
+        hits += grid.query_point(p.first, p.second).size();
+    cout << "grid point queries: " << ms_since(begin) << " ms, " << hits << " hits" << endl;
+
+    begin = Clock::now();
+    for (auto &p : points)
+        scan_nearest(circles, p.first, p.second, 5);
+    cout << "brute-force 5-nearest: " << ms_since(begin) << " ms" << endl;
+
+    begin = Clock::now();
+    for (auto &p : points)
+        grid.nearest(p.first, p.second, 5);
+    cout << "grid 5-nearest: " << ms_since(begin) << " ms" << endl;
+
+    // move some circles through the grid and check the answers still match the scan
+    for (unsigned i = 0; i < n; i += 10)
+        grid.move_to(i, pos(gen), pos(gen));
+    for (unsigned i = 1; i < n; i += 10)
+        grid.scalar(i, 2);
+    for (auto &p : points)
+    {
+        std::vector<unsigned> a = grid.query_point(p.first, p.second), b = scan_point(circles, p.first, p.second);
+        std::sort(a.begin(), a.end());
+        if (a != b || grid.nearest(p.first, p.second, 5) != scan_nearest(circles, p.first, p.second, 5))
+            mismatches++;
+    }
+    cout << "mismatches after updates: " << mismatches << endl;
+
+    // a point far away from every circle: the search starts at the nearest used
+    // cell, so this costs about as much as a query inside the data
+    std::vector<Circle> few;
+    few.reserve(105);
+    for (unsigned i = 0; i < 100; i++)
+        few.emplace_back("red", rad(gen), pos(gen) / 10, pos(gen) / 10);
+    CircleGrid small(1);
+    small.build(few);
+    size_t far_mismatches = 0;
+    begin = Clock::now();
+    for (double far : {1000.0, 3000.0, 1e6, -1e9})
+        if (small.nearest(far, far, 3) != scan_nearest(few, far, far, 3) ||
+            small.nearest(far, -far, 3) != scan_nearest(few, far, -far, 3))
+            far_mismatches++;
+    cout << "far-away 3-nearest: " << ms_since(begin) << " ms, " << far_mismatches << " mismatches" << endl;
+
+    // a few huge circles go into the big list instead of thousands of cells
+    std::uniform_real_distribution<double> huge(20, 5000);
+    for (unsigned i = 0; i < 5; i++)
+    {
+        few.emplace_back("blue", huge(gen), pos(gen), pos(gen));
+        small.insert(few.back());
+    }
+    size_t big_mismatches = 0;
+    for (unsigned i = 0; i < 200; i++)
+    {
+        double ax = pos(gen) - 500, ay = pos(gen) - 500, bx = pos(gen) - 500, by = pos(gen) - 500;
+        std::vector<unsigned> a = small.query_rect(ax, ay, bx, by); // corners in any order
+        std::vector<unsigned> b = scan_rect(few, std::min(ax, bx), std::min(ay, by), std::max(ax, bx), std::max(ay, by));
+        std::vector<unsigned> c = small.query_point(ax, ay), d = scan_point(few, ax, ay);
+        std::sort(a.begin(), a.end());
+        std::sort(c.begin(), c.end());
+        if (a != b || c != d || small.nearest(ax, ay, 3) != scan_nearest(few, ax, ay, 3))
+            big_mismatches++;
+    }
+    cout << "with huge circles: " << big_mismatches << " mismatches" << endl;
+
+    std::vector<unsigned> in_rect = grid.query_rect(100, 100, 120, 120);
+    cout << "circles overlapping [100, 120] x [100, 120]: " << in_rect.size() << endl;
+
+    return 0;
+}
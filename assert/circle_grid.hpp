@@ -0,0 +1,349 @@
+#ifndef CIRCLE_GRID_H_
+#define CIRCLE_GRID_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "class.hpp"
+
+// Uniform grid over Circle objects.
+// The plane is cut into square cells of cell_size, and each circle is listed
+// in every cell its bounding square touches. A query then only looks at the
+// circles listed in the cells it touches instead of scanning all of them.
+// The grid keeps a copy of each circle's position and radius; after calling
+// move_to or scalar on an indexed circle, call update(id), or use the
+// move_to/scalar wrappers below which do both.
+// The grid points at the circles, it doesn't own them: build() and insert()
+// keep the address of each circle, so anything that moves them, e.g. a
+// push_back that makes the vector grow, leaves the grid pointing at freed
+// memory. Reserve first, or build() again after the vector changed.
+// A circle wider than big_span cells would have to be listed in big_span^2
+// cells or more, so it goes into one list of big circles instead, and every
+// query checks that whole list. A few huge circles are fine, many are a scan.
+// Queries keep no state, so threads may run them on the same grid at once
+// as long as nobody changes it meanwhile.
+class CircleGrid
+{
+private:
+    struct Item
+    {
+        Circle *circle;
+        double x;
+        double y;
+        double r;
+        bool alive;
+    };
+
+    static constexpr double big_span = 8;
+
+    double cell_size_;
+    std::vector<Item> items_;
+    std::unordered_map<uint64_t, std::vector<unsigned>> cells_;
+    std::vector<unsigned> big_; // circles too wide to list in cells
+    int64_t min_cx_ = 0, min_cy_ = 0, max_cx_ = -1, max_cy_ = -1; // cells ever used
+
+    int64_t cell_of(double v) const { return static_cast<int64_t>(std::floor(v / cell_size_)); }
+    static uint64_t key(int64_t cx, int64_t cy) { return (static_cast<uint64_t>(cx) << 32) ^ static_cast<uint32_t>(cy); }
+    bool is_big(const Item &item) const { return 2 * item.r > big_span * cell_size_; }
+
+    void link(unsigned id);
+    void unlink(unsigned id);
+    // whether the circle overlaps the rectangle
+    static bool overlaps(const Item &item, double min_x, double min_y, double max_x, double max_y);
+
+    // distance from (x, y) to the disk of the item, 0 when inside
+    double distance(const Item &item, double x, double y) const;
+    // distance from (x, y) to the cells [x0, x1] x [y0, y1], infinity when there are none
+    double distance_to_cells(double x, double y, int64_t x0, int64_t x1, int64_t y0, int64_t y1) const;
+    // distance from (x, y) to the used cells outside the square of cells around (sx, sy) with radius ring
+    double distance_beyond(double x, double y, int64_t sx, int64_t sy, int64_t ring) const;
+    // offer a circle to nearest()
+    void offer(unsigned id, double x, double y, size_t k, std::vector<std::pair<double, unsigned>> &best) const;
+    // offer the circles listed in a cell to nearest()
+    void visit_cell(int64_t cx, int64_t cy, double x, double y, size_t k,
+                    std::vector<std::pair<double, unsigned>> &best) const;
+
+public:
+    explicit CircleGrid(double cell_size = 1) : cell_size_(cell_size) {}
+
+    // index a whole set of circles at once, ids are their positions in the vector;
+    // the vector must not grow or be moved while the grid is in use
+    void build(std::vector<Circle> &circles);
+    unsigned insert(Circle &c);
+    void remove(unsigned id);
+    // re-read the circle after its position or radius changed
+    void update(unsigned id);
+
+    void move_to(unsigned id, double x_index, double y_index);
+    void scalar(unsigned id, double d);
+
+    Circle &get(unsigned id) { return *items_[id].circle; }
+
+    // ids of circles containing the point
+    std::vector<unsigned> query_point(double x, double y) const;
+    // ids of circles overlapping the rectangle; the corners may come in any order
+    std::vector<unsigned> query_rect(double min_x, double min_y, double max_x, double max_y) const;
+    // ids of the k circles nearest to the point, nearest first
+    std::vector<unsigned> nearest(double x, double y, size_t k) const;
+};
+
+inline void CircleGrid::link(unsigned id)
+{
+    const Item &item = items_[id];
+    if (is_big(item))
+    {
+        big_.push_back(id);
+        return;
+    }
+    int64_t x0 = cell_of(item.x - item.r), x1 = cell_of(item.x + item.r);
+    int64_t y0 = cell_of(item.y - item.r), y1 = cell_of(item.y + item.r);
+    for (int64_t cx = x0; cx <= x1; cx++)
+        for (int64_t cy = y0; cy <= y1; cy++)
+            cells_[key(cx, cy)].push_back(id);
+
+    if (max_cx_ < min_cx_)
+    {
+        min_cx_ = x0; max_cx_ = x1;
+        min_cy_ = y0; max_cy_ = y1;
+    }
+    else
+    {
+        min_cx_ = std::min(min_cx_, x0); max_cx_ = std::max(max_cx_, x1);
+        min_cy_ = std::min(min_cy_, y0); max_cy_ = std::max(max_cy_, y1);
+    }
+}
+
+inline void CircleGrid::unlink(unsigned id)
+{
+    const Item &item = items_[id];
+    if (is_big(item))
+    {
+        big_.erase(std::find(big_.begin(), big_.end(), id));
+        return;
+    }
+    int64_t x0 = cell_of(item.x - item.r), x1 = cell_of(item.x + item.r);
+    int64_t y0 = cell_of(item.y - item.r), y1 = cell_of(item.y + item.r);
+    for (int64_t cx = x0; cx <= x1; cx++)
+        for (int64_t cy = y0; cy <= y1; cy++)
+        {
+            auto found = cells_.find(key(cx, cy));
+            if (found == cells_.end())
+                continue;
+            std::vector<unsigned> &cell = found->second;
+            auto it = std::find(cell.begin(), cell.end(), id);
+            if (it != cell.end())
+            {
+                *it = cell.back(); // order inside a cell doesn't matter
+                cell.pop_back();
+            }
+            if (cell.empty())
+                cells_.erase(found); // don't let moving circles leave a trail of empty cells
+        }
+}
+
+inline bool CircleGrid::overlaps(const Item &item, double min_x, double min_y, double max_x, double max_y)
+{
+    // closest point of the rectangle to the centre
+    double dx = item.x - std::clamp(item.x, min_x, max_x);
+    double dy = item.y - std::clamp(item.y, min_y, max_y);
+    return dx * dx + dy * dy <= item.r * item.r;
+}
+
+inline double CircleGrid::distance(const Item &item, double x, double y) const
+{
+    double d = std::hypot(item.x - x, item.y - y) - item.r;
+    return d > 0 ? d : 0;
+}
+
+inline double CircleGrid::distance_to_cells(double x, double y, int64_t x0, int64_t x1, int64_t y0, int64_t y1) const
+{
+    if (x0 > x1 || y0 > y1)
+        return HUGE_VAL;
+    double dx = std::max({x0 * cell_size_ - x, 0.0, x - (x1 + 1) * cell_size_});
+    double dy = std::max({y0 * cell_size_ - y, 0.0, y - (y1 + 1) * cell_size_});
+    return std::hypot(dx, dy);
+}
+
+inline double CircleGrid::distance_beyond(double x, double y, int64_t sx, int64_t sy, int64_t ring) const
+{
+    // the used cells minus the square are at most four strips: left, right, below, above
+    int64_t x0 = sx - ring, x1 = sx + ring, y0 = sy - ring, y1 = sy + ring;
+    int64_t mx0 = std::max(x0, min_cx_), mx1 = std::min(x1, max_cx_);
+    return std::min({distance_to_cells(x, y, min_cx_, std::min(max_cx_, x0 - 1), min_cy_, max_cy_),
+                     distance_to_cells(x, y, std::max(min_cx_, x1 + 1), max_cx_, min_cy_, max_cy_),
+                     distance_to_cells(x, y, mx0, mx1, min_cy_, std::min(max_cy_, y0 - 1)),
+                     distance_to_cells(x, y, mx0, mx1, std::max(min_cy_, y1 + 1), max_cy_)});
+}
+
+inline void CircleGrid::offer(unsigned id, double x, double y, size_t k,
+                              std::vector<std::pair<double, unsigned>> &best) const
+{
+    double d = distance(items_[id], x, y);
+    if (best.size() == k && d >= best.back().first)
+        return;
+    // a circle listed in several cells is offered once per cell; best is at most k long
+    auto pos = std::upper_bound(best.begin(), best.end(), std::make_pair(d, id));
+    if (pos != best.begin() && (pos - 1)->second == id)
+        return;
+    best.insert(pos, std::make_pair(d, id));
+    if (best.size() > k)
+        best.pop_back();
+}
+
+inline void CircleGrid::visit_cell(int64_t cx, int64_t cy, double x, double y, size_t k,
+                                   std::vector<std::pair<double, unsigned>> &best) const
+{
+    auto it = cells_.find(key(cx, cy));
+    if (it == cells_.end())
+        return;
+    for (unsigned id : it->second)
+        offer(id, x, y, k, best);
+}
+
+inline void CircleGrid::build(std::vector<Circle> &circles)
+{
+    items_.clear();
+    cells_.clear();
+    big_.clear();
+    max_cx_ = min_cx_ - 1;
+    items_.reserve(circles.size());
+    for (Circle &c : circles)
+        insert(c);
+}
+
+inline unsigned CircleGrid::insert(Circle &c)
+{
+    unsigned id = static_cast<unsigned>(items_.size());
+    items_.push_back(Item{&c, c.get_x_index(), c.get_y_index(), c.get_rand(), true});
+    link(id);
+    return id;
+}
+
+inline void CircleGrid::remove(unsigned id)
+{
+    if (!items_[id].alive)
+        return;
+    unlink(id);
+    items_[id].alive = false;
+}
+
+inline void CircleGrid::update(unsigned id)
+{
+    Item &item = items_[id];
+    if (!item.alive)
+        return;
+    unlink(id);
+    item.x = item.circle->get_x_index();
+    item.y = item.circle->get_y_index();
+    item.r = item.circle->get_rand();
+    link(id);
+}
+
+inline void CircleGrid::move_to(unsigned id, double x_index, double y_index)
+{
+    items_[id].circle->move_to(x_index, y_index);
+    update(id);
+}
+
+inline void CircleGrid::scalar(unsigned id, double d)
+{
+    items_[id].circle->scalar(d);
+    update(id);
+}
+
+inline std::vector<unsigned> CircleGrid::query_point(double x, double y) const
+{
+    std::vector<unsigned> result;
+    auto it = cells_.find(key(cell_of(x), cell_of(y)));
+    if (it != cells_.end())
+        for (unsigned id : it->second)
+            if (overlaps(items_[id], x, y, x, y))
+                result.push_back(id);
+    for (unsigned id : big_)
+        if (overlaps(items_[id], x, y, x, y))
+            result.push_back(id);
+    return result;
+}
+
+inline std::vector<unsigned> CircleGrid::query_rect(double min_x, double min_y, double max_x, double max_y) const
+{
+    if (min_x > max_x)
+        std::swap(min_x, max_x);
+    if (min_y > max_y)
+        std::swap(min_y, max_y);
+
+    std::vector<unsigned> result;
+    int64_t x0 = std::max(cell_of(min_x), min_cx_), x1 = std::min(cell_of(max_x), max_cx_);
+    int64_t y0 = std::max(cell_of(min_y), min_cy_), y1 = std::min(cell_of(max_y), max_cy_);
+    for (int64_t cx = x0; cx <= x1; cx++)
+        for (int64_t cy = y0; cy <= y1; cy++)
+        {
+            auto it = cells_.find(key(cx, cy));
+            if (it == cells_.end())
+                continue;
+            for (unsigned id : it->second)
+            {
+                // a circle is listed in every cell it touches; only the first
+                // of those inside the rectangle's cells reports it
+                const Item &item = items_[id];
+                if (cx != std::max(cell_of(item.x - item.r), x0) || cy != std::max(cell_of(item.y - item.r), y0))
+                    continue;
+                if (overlaps(item, min_x, min_y, max_x, max_y))
+                    result.push_back(id);
+            }
+        }
+    for (unsigned id : big_)
+        if (overlaps(items_[id], min_x, min_y, max_x, max_y))
+            result.push_back(id);
+    return result;
+}
+
+inline std::vector<unsigned> CircleGrid::nearest(double x, double y, size_t k) const
+{
+    std::vector<std::pair<double, unsigned>> best; // (distance, id), kept sorted, at most k long
+    if (k == 0)
+        return {};
+    for (unsigned id : big_)
+        offer(id, x, y, k, best);
+
+    // Walk rings of cells around the used cell closest to the point, so a
+    // point far away from all circles costs no more than one inside them.
+    // Only the cells on the ring and inside the used area are visited. A
+    // circle not seen after ring R lies completely in used cells outside
+    // it, so it is at least distance_beyond() away.
+    bool used = min_cx_ <= max_cx_; // false while the grid holds only big circles
+    int64_t sx = used ? std::clamp(cell_of(x), min_cx_, max_cx_) : 0;
+    int64_t sy = used ? std::clamp(cell_of(y), min_cy_, max_cy_) : 0;
+    for (int64_t ring = 0; used; ring++)
+    {
+        int64_t x0 = std::max(sx - ring, min_cx_), x1 = std::min(sx + ring, max_cx_);
+        int64_t y0 = std::max(sy - ring + 1, min_cy_), y1 = std::min(sy + ring - 1, max_cy_);
+        if (sy - ring >= min_cy_) // bottom row
+            for (int64_t i = x0; i <= x1; i++)
+                visit_cell(i, sy - ring, x, y, k, best);
+        if (ring > 0 && sy + ring <= max_cy_) // top row
+            for (int64_t i = x0; i <= x1; i++)
+                visit_cell(i, sy + ring, x, y, k, best);
+        if (ring > 0 && sx - ring >= min_cx_) // left column, without the corners
+            for (int64_t j = y0; j <= y1; j++)
+                visit_cell(sx - ring, j, x, y, k, best);
+        if (ring > 0 && sx + ring <= max_cx_) // right column
+            for (int64_t j = y0; j <= y1; j++)
+                visit_cell(sx + ring, j, x, y, k, best);
+
+        double beyond = distance_beyond(x, y, sx, sy, ring);
+        if (beyond == HUGE_VAL || (best.size() == k && best.back().first <= beyond))
+            break;
+    }
+
+    std::vector<unsigned> result;
+    for (auto &entry : best)
+        result.push_back(entry.second);
+    return result;
+}
+
+#endif
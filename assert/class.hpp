@@ -2,31 +2,55 @@
 #define CLASS_H_
 
 #include <iostream>
+#include <stdexcept>
 #include <string>
 
+#include "color_table.hpp"
+#include "output_sink.hpp"
+
 #define PI 3.14
 
 using ::std::string;
 using ::std::cout;
 using ::std::endl;
 
+// Define CIRCLE_SILENT to compile out the message every Circle prints when it
+// is destroyed.
+
 class Circle
 {
 private:
     double rand_;
-    string color_;
     double x_index_;
     double y_index_;
+    unsigned color_id_; // interned in ColorTable; last, so the doubles need no padding in between
 public:
     Circle(const string &color = "red", double rand = 1, double x_index = 0, double y_index = 0);
-    ~Circle() { cout << "free the circle: " << color_ << endl; }
+    ~Circle()
+    {
+#ifndef CIRCLE_SILENT
+        log_sink() << "free the circle: " << get_color() << '\n';
+#endif
+    }
     void init(const string &color, double rand, double x_index, double y_index);
     void change_color(const string &color);
+    // color_id must come from ColorTable, e.g. another circle's get_color_id()
+    void change_color(unsigned color_id);
     void move_to(double x_index, double y_index);
     void scalar(double d);
-    void show();
+    // print to out, log_sink() by default; nothing is flushed here
+    void show(std::ostream &out = log_sink());
+    // {"color":...,"rand":...,"x_index":...,"y_index":...} on one line
+    void show_json(std::ostream &out = log_sink());
+    // colour id followed by rand, x_index and y_index as raw bytes
+    void show_binary(std::ostream &out);
     double square();
-    const string &get_color() { return color_; }
+    // Looks the name up in ColorTable under its shared lock, an atomic write to
+    // a cache line every thread shares. Cheap next to printing, but in a hot
+    // loop compare with same_color() or get_color_id() instead.
+    const string &get_color() const { return ColorTable::instance().name(color_id_); }
+    unsigned get_color_id() const { return color_id_; }
+    bool same_color(const Circle &c) const { return color_id_ == c.color_id_; }
     double get_rand() { return rand_; }
     double get_x_index() { return x_index_; }
     double get_y_index() { return y_index_; }
@@ -34,27 +58,34 @@ public:
 
 Circle::Circle(const string &color, double rand, double x_index, double y_index)
 {
-    if(rand_ < 0)
+    if(rand < 0)
         abort();
     rand_ = rand;
-    color_ = color;
+    color_id_ = ColorTable::instance().intern(color);
     x_index_ = x_index;
     y_index_ = y_index;
 }
 
 void Circle::init(const string &color, double rand, double x_index, double y_index)
 {
-    if(rand_ < 0)
+    if(rand < 0)
         abort();
     rand_ = rand;
-    color_ = color;
+    color_id_ = ColorTable::instance().intern(color);
     x_index_ = x_index;
     y_index_ = y_index;
 }
 
 void Circle::change_color(const string &color)
 {
-    color_ = color;
+    color_id_ = ColorTable::instance().intern(color);
+}
+
+void Circle::change_color(unsigned color_id)
+{
+    if (color_id >= ColorTable::instance().size())
+        throw std::out_of_range("Circle::change_color: unknown colour id");
+    color_id_ = color_id;
 }
 
 void Circle::move_to(double x_index, double y_index)
@@ -70,13 +101,42 @@ void Circle::scalar(double scale)
     rand_ *= scale;
 }
 
-void Circle::show()
+void Circle::show(std::ostream &out)
+{
+    out << "rand: " << rand_ << '\n'
+        << "color: " << get_color() << '\n'
+        << "x_index: " << x_index_ << '\n'
+        << "y_index: " << y_index_ << '\n'
+        << '\n';
+}
+
+void Circle::show_json(std::ostream &out)
+{
+    out << "{\"color\":\"";
+    for (char ch : get_color())
+    {
+        if (static_cast<unsigned char>(ch) < 0x20)
+        {
+            // control characters must be escaped as \u00XX
+            const char *hex = "0123456789abcdef";
+            out << "\\u00" << hex[(ch >> 4) & 0xf] << hex[ch & 0xf];
+            continue;
+        }
+        if (ch == '"' || ch == '\\')
+            out << '\\';
+        out << ch;
+    }
+    out << "\",\"rand\":" << rand_
+        << ",\"x_index\":" << x_index_
+        << ",\"y_index\":" << y_index_ << "}\n";
+}
+
+void Circle::show_binary(std::ostream &out)
 {
-    cout << "rand: " << rand_ << endl;
-    cout << "color: " << color_ << endl;
-    cout << "x_index: " << x_index_ << endl;
-    cout << "y_index: " << y_index_ << endl;
-    cout << endl;
+    out.write(reinterpret_cast<const char *>(&color_id_), sizeof(color_id_));
+    out.write(reinterpret_cast<const char *>(&rand_), sizeof(rand_));
+    out.write(reinterpret_cast<const char *>(&x_index_), sizeof(x_index_));
+    out.write(reinterpret_cast<const char *>(&y_index_), sizeof(y_index_));
 }
 
 double Circle::square()
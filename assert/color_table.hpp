@@ -0,0 +1,72 @@
+#ifndef COLOR_TABLE_H_
+#define COLOR_TABLE_H_
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// Interns colour names into small integer ids.
+// A program only ever uses a few dozen colours, so objects keep the id
+// and compare colours with a single integer compare.
+// Names live in a deque, which never moves its elements, so a reference
+// returned by name() stays valid for the rest of the program.
+class ColorTable
+{
+private:
+    std::deque<std::string> names_;                  // id -> name
+    std::unordered_map<std::string, unsigned> ids_;  // name -> id
+    mutable std::shared_mutex mutex_;
+
+    ColorTable() = default;
+
+public:
+    ColorTable(const ColorTable &) = delete;
+    ColorTable &operator=(const ColorTable &) = delete;
+
+    static ColorTable &instance()
+    {
+        static ColorTable table;
+        return table;
+    }
+
+    // id of the colour, adding it on first use
+    unsigned intern(const std::string &color);
+    const std::string &name(unsigned id) const;
+    size_t size() const;
+};
+
+inline unsigned ColorTable::intern(const std::string &color)
+{
+    {
+        // the common case: the colour is already known, readers don't block each other
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto it = ids_.find(color);
+        if (it != ids_.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = ids_.find(color); // another thread may have added it meanwhile
+    if (it != ids_.end())
+        return it->second;
+    unsigned id = static_cast<unsigned>(names_.size());
+    names_.push_back(color);
+    ids_.emplace(color, id);
+    return id;
+}
+
+inline const std::string &ColorTable::name(unsigned id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_[id];
+}
+
+inline size_t ColorTable::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return names_.size();
+}
+
+#endif
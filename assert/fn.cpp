@@ -1,38 +1,41 @@
+#include <complex>
 #include <iostream>
+#include <string>
+#include <vector>
+
+#include "fn.hpp"
 
 using namespace std;
 
-template <class T, int n>
-class Add
+template <class T>
+class Fn
 {
 public:
-    T *operator()(const T a[n], const T b[n])
+    void operator()(const T &t)
     {
-        T *result = new T[n];
-        for (int i = 0; i < n; i++)
-            result[i] = a[i] + b[i];
-        return result;
+        cout << t << endl;
     }
 };
 
-template <class T, template <class U> class F, int n>
-class Traverse
+// keeps a running total, so it has to be constructed once and passed in
+template <class T>
+class Sum
 {
 public:
-    void operator()(T t[n])
+    T total = 0;
+    void operator()(const T &t)
     {
-        for(int i = 0; i < n; i++)
-            F<T>()(t[i]);
+        total += t;
     }
 };
 
 template <class T>
-class Fn
+class Square
 {
 public:
-    void operator()(const T &t)
+    void operator()(T &t) const
     {
-        cout << t << endl;
+        t = t * t;
     }
 };
 
@@ -41,7 +44,46 @@ int main()
     int a[5] = {1, 2, 3, 4};
     int b[5]{5, 4, 5, 6, 1};
 
-    int *result = Add<int, 5>()(a, b);
+    int result[5];
+    Add<int, 5>()(a, b, result);
 
     Traverse<int, Fn, 5>()(result);
-}
\ No newline at end of file
+
+    cout << "a + b + result in one pass" << endl;
+    int total[5];
+    Add<int, 5>().fused(total, a, b, result);
+    Traverse<int, Fn, 5>()(total);
+
+    constexpr array<int, 3> x{1, 2, 3}, y{10, 20, 30};
+    constexpr array<int, 3> z = Add<int, 3>()(x, y);
+    static_assert(z[0] == 11 && z[1] == 22 && z[2] == 33, "added at compile time");
+    cout << "computed by the compiler: " << z[0] << " " << z[1] << " " << z[2] << endl;
+
+    // not only numbers: any T with operator+ takes the plain loop
+    array<string, 2> words{"Add ", "Traverse "}, more{"strings", "too"};
+    array<string, 2> joined = Add<string, 2>()(words, more);
+    cout << joined[0] << ", " << joined[1] << endl;
+    array<complex<double>, 2> u{complex<double>(1, 2), complex<double>(3, 4)}, v{complex<double>(1, -1), 1.0};
+    array<complex<double>, 2> w = Add<complex<double>, 2>()(u, v);
+    cout << "complex: " << w[0] << " " << w[1] << endl;
+
+    cout << "Add and Traverse fused into one loop" << endl;
+    pipeline<int, 5>(a).add(b).for_each<Fn>().run();
+
+    constexpr int dot = pipeline<int, 3>(x).zip(y, multiplies<int>()).reduce(0, plus<int>());
+    static_assert(dot == 140, "pipeline evaluated at compile time");
+    cout << "dot product computed by the compiler: " << dot << endl;
+
+    Sum<int> sum;
+    Traverse<int, Sum, 5>()(traverse_policy::unroll, total, sum);
+    cout << "sum of the fused result: " << sum.total << endl;
+
+    // the length is only known at run time; square them on every core
+    vector<long> numbers(1000000);
+    for (size_t i = 0; i < numbers.size(); i++)
+        numbers[i] = long(i % 1000);
+    Traverse<long, Square, dynamic_length>()(traverse_policy::par, numbers);
+    Sum<long> squares;
+    Traverse<long, Sum, dynamic_length>()(traverse_policy::seq, numbers, squares);
+    cout << "sum of 1000000 squares: " << squares.total << endl;
+}
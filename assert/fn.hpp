@@ -0,0 +1,388 @@
+#ifndef FN_H_
+#define FN_H_
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Class templates from fn.cpp. Needs C++20 for std::span.
+
+// GCC and clang can describe a SIMD register as a plain type, e.g. 4 doubles
+// or 8 ints in 32 bytes, and compile + on it to one vector instruction.
+#if defined(__GNUC__)
+#define FN_VECTOR_EXTENSIONS 1
+#endif
+
+#ifdef FN_VECTOR_EXTENSIONS
+namespace fn_detail
+{
+// Add's vector path. vector_size only takes arithmetic types, so this lives
+// outside Add and is only instantiated when Add<T, n> can use it.
+template <class T, int n>
+struct SimdSum
+{
+    static constexpr int lanes = 32 / sizeof(T);
+    typedef T block __attribute__((vector_size(32)));
+
+    // out[i] = (in[i] + ...) 32 bytes at a time, the rest one by one
+    template <class... In>
+    static void sum(T *out, const T *first, const In *... rest)
+    {
+        int i = 0;
+        for (; i + lanes <= n; i += lanes)
+        {
+            block total, next; // memcpy, so the arrays need no alignment
+            std::memcpy(&total, first + i, sizeof(block));
+            ((std::memcpy(&next, rest + i, sizeof(block)), total += next), ...);
+            std::memcpy(out + i, &total, sizeof(block));
+        }
+        for (; i < n; i++)
+            out[i] = (first[i] + ... + rest[i]);
+    }
+};
+}
+#endif
+
+template <class T, int n>
+class Add
+{
+private:
+    static constexpr bool use_simd = std::is_arithmetic_v<T> && !std::is_same_v<T, bool>;
+
+    template <class... In>
+    static constexpr void sum(T *out, const In *... in)
+    {
+#ifdef FN_VECTOR_EXTENSIONS
+        if constexpr (use_simd)
+        {
+            if (!std::is_constant_evaluated())
+            {
+                fn_detail::SimdSum<T, n>::sum(out, in...);
+                return;
+            }
+        }
+#endif
+        for (int i = 0; i < n; i++)
+            out[i] = (in[i] + ...);
+    }
+
+public:
+    // allocates the result, the caller has to delete[] it
+    T *operator()(const T a[n], const T b[n])
+    {
+        T *result = new T[n];
+        sum(result, a, b);
+        return result;
+    }
+
+    // writes a + b into out, nothing is allocated.
+    // out may be a or b, but must not partly overlap them.
+    constexpr void operator()(std::span<const T, n> a, std::span<const T, n> b, std::span<T, n> out) const
+    {
+        sum(out.data(), a.data(), b.data());
+    }
+
+    // returns the sum by value, for small n the compiler can do it all at compile time
+    constexpr std::array<T, n> operator()(const std::array<T, n> &a, const std::array<T, n> &b) const
+    {
+        std::array<T, n> result{};
+        sum(result.data(), a.data(), b.data());
+        return result;
+    }
+
+    // out = in[0] + in[1] + ... in one pass, without intermediate results.
+    // Each input is anything that converts to std::span<const T, n>: T[n], std::array or a span.
+    template <class... In>
+    constexpr void fused(std::span<T, n> out, const In &... in) const
+    {
+        static_assert(sizeof...(In) >= 1, "at least one input");
+        sum(out.data(), std::span<const T, n>(in).data()...);
+    }
+};
+
+// How Traverse walks the elements, in the spirit of std::execution:
+//     seq     one element after the other
+//     unroll  four elements per loop step, fewer loop branches
+//     simd    tells the compiler the calls don't depend on each other, so it may vectorize them
+//     par     splits the elements into chunks, one thread per chunk; f is shared by the
+//             threads, so it must be safe to call concurrently
+namespace traverse_policy
+{
+struct sequential_policy {};
+struct unrolled_policy {};
+struct simd_policy {};
+struct parallel_policy
+{
+    unsigned threads = 0;    // 0: one per hardware thread
+    size_t min_chunk = 4096; // fewer elements per thread aren't worth starting it
+};
+
+inline constexpr sequential_policy seq{};
+inline constexpr unrolled_policy unroll{};
+inline constexpr simd_policy simd{};
+inline constexpr parallel_policy par{};
+
+template <class T, class Func>
+void for_each(sequential_policy, std::span<T> t, Func &f)
+{
+    for (size_t i = 0; i < t.size(); i++)
+        f(t[i]);
+}
+
+template <class T, class Func>
+void for_each(unrolled_policy, std::span<T> t, Func &f)
+{
+    size_t i = 0;
+    for (; i + 4 <= t.size(); i += 4)
+    {
+        f(t[i]);
+        f(t[i + 1]);
+        f(t[i + 2]);
+        f(t[i + 3]);
+    }
+    for (; i < t.size(); i++)
+        f(t[i]);
+}
+
+template <class T, class Func>
+void for_each(simd_policy, std::span<T> t, Func &f)
+{
+    T *data = t.data();
+    const size_t count = t.size();
+#if defined(__clang__)
+#pragma clang loop vectorize(enable) interleave(enable)
+#elif defined(__GNUC__)
+#pragma GCC ivdep
+#endif
+    for (size_t i = 0; i < count; i++)
+        f(data[i]);
+}
+
+template <class T, class Func>
+void for_each(parallel_policy policy, std::span<T> t, Func &f)
+{
+    size_t threads = policy.threads ? policy.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t min_chunk = std::max<size_t>(1, policy.min_chunk);
+    size_t chunks = std::min(threads, (t.size() + min_chunk - 1) / min_chunk);
+    if (chunks <= 1)
+    {
+        for_each(seq, t, f);
+        return;
+    }
+    size_t chunk = (t.size() + chunks - 1) / chunks;
+    chunks = (t.size() + chunk - 1) / chunk;
+
+    // an exception in a worker is passed back and rethrown here
+    std::vector<std::exception_ptr> errors(chunks);
+    auto work = [&](size_t c)
+    {
+        try
+        {
+            for_each(seq, t.subspan(c * chunk, std::min(chunk, t.size() - c * chunk)), f);
+        }
+        catch (...)
+        {
+            errors[c] = std::current_exception();
+        }
+    };
+
+    // if a thread can't be started, the calling thread does the chunks that
+    // got none; throwing here would leave the started ones unjoined
+    std::vector<std::thread> workers;
+    size_t started = 1;
+    try
+    {
+        workers.reserve(chunks - 1);
+        for (; started < chunks; started++)
+            workers.emplace_back(work, started);
+    }
+    catch (...)
+    {
+    }
+    work(0); // the calling thread takes the first chunk
+    for (size_t c = started; c < chunks; c++)
+        work(c);
+    for (std::thread &worker : workers)
+        worker.join();
+    for (std::exception_ptr &error : errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+}
+
+// Calls F<T> on each of the n elements of an array.
+// The functor is constructed once per call, not once per element. Pass your
+// own F<T> to keep its state, e.g. a running total, after the walk.
+template <class T, template <class U> class F, int n>
+class Traverse
+{
+public:
+    void operator()(T t[n])
+    {
+        F<T> f;
+        traverse_policy::for_each(traverse_policy::seq, std::span<T>(t, n), f);
+    }
+
+    template <class Policy>
+    void operator()(Policy policy, T t[n])
+    {
+        F<T> f;
+        traverse_policy::for_each(policy, std::span<T>(t, n), f);
+    }
+
+    template <class Policy>
+    void operator()(Policy policy, T t[n], F<T> &f)
+    {
+        traverse_policy::for_each(policy, std::span<T>(t, n), f);
+    }
+};
+
+// n for a Traverse whose length is only known at run time
+constexpr int dynamic_length = -1;
+
+// Traverse<T, F, dynamic_length> walks a std::span of any length
+template <class T, template <class U> class F>
+class Traverse<T, F, dynamic_length>
+{
+public:
+    void operator()(std::span<T> t)
+    {
+        F<T> f;
+        traverse_policy::for_each(traverse_policy::seq, t, f);
+    }
+
+    template <class Policy>
+    void operator()(Policy policy, std::span<T> t)
+    {
+        F<T> f;
+        traverse_policy::for_each(policy, t, f);
+    }
+
+    template <class Policy>
+    void operator()(Policy policy, std::span<T> t, F<T> &f)
+    {
+        traverse_policy::for_each(policy, t, f);
+    }
+};
+
+// Stages of a Pipeline. Each one takes the current value of element i and
+// returns the value the next stage gets.
+template <class F>
+struct MapStage
+{
+    F f;
+    template <class T>
+    constexpr T operator()(const T &v, size_t) { return f(v); }
+};
+
+template <class T, class F>
+struct ZipStage
+{
+    const T *other;
+    F f;
+    constexpr T operator()(const T &v, size_t i) { return f(v, other[i]); }
+};
+
+template <class F>
+struct ForEachStage
+{
+    F f;
+    template <class T>
+    constexpr T operator()(const T &v, size_t)
+    {
+        f(v);
+        return v;
+    }
+};
+
+// Chain of Add and Traverse style steps, run as a single loop.
+// pipeline<int, 5>(a).add(b).for_each<Fn>().run() does what
+// Traverse<int, Fn, 5>()(Add<int, 5>()(a, b)) did, but each element goes
+// through every stage before the next element is read, so there is no
+// intermediate array and the data is only read once. The stages are part of
+// the type, so the compiler sees the whole chain and inlines it.
+template <class T, int n, class... Stages>
+class Pipeline
+{
+private:
+    const T *source_;
+    std::tuple<Stages...> stages_;
+
+    template <class S>
+    constexpr Pipeline<T, n, Stages..., S> then(S stage) const
+    {
+        return Pipeline<T, n, Stages..., S>(source_, std::tuple_cat(stages_, std::make_tuple(stage)));
+    }
+
+    // runs element i through a copy of the stages
+    template <class Sink>
+    constexpr void loop(Sink sink) const
+    {
+        std::tuple<Stages...> stages = stages_; // copied, so functors with state work on a const pipeline
+        for (int i = 0; i < n; i++)
+        {
+            T v = source_[i];
+            std::apply([&](auto &... stage) { ((v = stage(v, size_t(i))), ...); }, stages);
+            sink(v, i);
+        }
+    }
+
+public:
+    constexpr Pipeline(const T *source, std::tuple<Stages...> stages) : source_(source), stages_(stages) {}
+
+    // v = f(v)
+    template <class F>
+    constexpr auto map(F f) const { return then(MapStage<F>{f}); }
+    template <template <class U> class F>
+    constexpr auto map() const { return map(F<T>()); }
+
+    // v = f(v, other[i])
+    template <class F>
+    constexpr auto zip(std::span<const T, n> other, F f) const { return then(ZipStage<T, F>{other.data(), f}); }
+    // v = v + other[i], what Add does
+    constexpr auto add(std::span<const T, n> other) const { return zip(other, std::plus<T>()); }
+
+    // calls f(v) and passes v on unchanged, what Traverse does
+    template <class F>
+    constexpr auto for_each(F f) const { return then(ForEachStage<F>{f}); }
+    template <template <class U> class F>
+    constexpr auto for_each() const { return for_each(F<T>()); }
+
+    // run the chain for its side effects
+    constexpr void run() const
+    {
+        loop([](const T &, int) {});
+    }
+
+    // run the chain and keep the results
+    constexpr void into(std::span<T, n> out) const
+    {
+        loop([&](const T &v, int i) { out[i] = v; });
+    }
+
+    // run the chain and fold the results into one value
+    template <class R, class F>
+    constexpr R reduce(R init, F f) const
+    {
+        loop([&](const T &v, int) { init = f(init, v); });
+        return init;
+    }
+};
+
+// start a Pipeline over the n elements of source
+template <class T, int n>
+constexpr Pipeline<T, n> pipeline(std::span<const T, n> source)
+{
+    return Pipeline<T, n>(source.data(), std::tuple<>());
+}
+
+#undef FN_VECTOR_EXTENSIONS
+
+#endif
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "fn.hpp"
+
+using namespace std;
+
+// count every heap allocation the program makes
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *p = malloc(size))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+template <class Body>
+void bench(const char *name, long rounds, Body body)
+{
+    size_t before = allocations;
+    auto begin = chrono::steady_clock::now();
+    for (long i = 0; i < rounds; i++)
+        body();
+    auto end = chrono::steady_clock::now();
+    cout << name << ": " << chrono::duration<double, nano>(end - begin).count() / rounds << " ns/call, "
+         << allocations - before << " heap allocations" << endl;
+}
+
+template <class T, int n>
+void run(const char *type, long rounds)
+{
+    static array<T, n> a, b, c, out, tmp;
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = T(i);
+        b[i] = T(2 * i);
+        c[i] = T(3);
+    }
+
+    cout << "Add<" << type << ", " << n << ">, " << rounds << " calls" << endl;
+    bench("  new T[n] per call", rounds, [&] {
+        T *result = Add<T, n>()(a.data(), b.data());
+        a[0] = result[n - 1];
+        delete[] result;
+    });
+    bench("  into caller's span", rounds, [&] {
+        Add<T, n>()(a, b, out);
+        a[0] = out[n - 1];
+    });
+    bench("  std::array by value", rounds, [&] {
+        out = Add<T, n>()(a, b);
+        a[0] = out[n - 1];
+    });
+    bench("  a + b + c in two passes", rounds, [&] {
+        Add<T, n>()(a, b, tmp);
+        Add<T, n>()(tmp, c, out);
+        a[0] = out[n - 1];
+    });
+    bench("  a + b + c fused", rounds, [&] {
+        Add<T, n>().fused(out, a, b, c);
+        a[0] = out[n - 1];
+    });
+}
+
+template <class T>
+class Scale
+{
+public:
+    void operator()(T &t) const
+    {
+        t = t * T(1.0001) + T(0.5);
+    }
+};
+
+template <class Policy>
+void run_traverse(const char *name, Policy policy, vector<float> &data, long rounds)
+{
+    bench(name, rounds, [&] { Traverse<float, Scale, dynamic_length>()(policy, data); });
+}
+
+template <class T>
+class Twice
+{
+public:
+    void operator()(T &t) const
+    {
+        t = t * 2;
+    }
+};
+
+// out = (a + b) * 2, then sum it: Add and Traverse one after the other, then the same as one Pipeline
+void run_pipeline(long rounds)
+{
+    constexpr int n = 4096;
+    static array<double, n> a, b, tmp;
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = i * 0.5;
+        b[i] = 1;
+    }
+
+    cout << "sum of (a + b) * 2 over " << n << " doubles, " << rounds << " calls" << endl;
+    double total = 0;
+    bench("  Add, then Traverse", rounds, [&] {
+        Add<double, n>()(a, b, tmp);
+        Traverse<double, Twice, n>()(tmp.data());
+        for (double v : tmp)
+            total += v;
+    });
+    cout << "  checksum " << total << endl;
+
+    total = 0;
+    bench("  one Pipeline", rounds, [&] {
+        total += pipeline<double, n>(a).add(b).map([](double v) { return v * 2; }).reduce(0.0, plus<double>());
+    });
+    cout << "  checksum " << total << endl;
+}
+
+int main()
+{
+    run<int, 16>("int", 10000000);
+    run<float, 1024>("float", 1000000);
+    run<double, 4096>("double", 200000);
+
+    vector<float> data(1 << 22, 1.0f);
+    cout << "Traverse over " << data.size() << " floats, 50 calls" << endl;
+    run_traverse("  seq", traverse_policy::seq, data, 50);
+    run_traverse("  unroll", traverse_policy::unroll, data, 50);
+    run_traverse("  simd", traverse_policy::simd, data, 50);
+    run_traverse("  par", traverse_policy::par, data, 50);
+
+    run_pipeline(200000);
+    return 0;
+}
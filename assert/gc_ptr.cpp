@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cstring>
+#include <vector>
+
+#include "gc_ptr.hpp"
+
+using namespace std;
+
+class Father;
+class Son;
+
+class Father
+{
+public:
+    char name[16] { 0 };
+    gc_ptr<Son> son {};
+    Father(const char *nm)
+    {
+        strncpy(name, nm, 16);
+        cout << "created Father" << endl;
+    }
+    ~Father() { cout << "destoryed Father" << endl; }
+    void trace(GcTracer &t) { t(son); }
+};
+
+class Son
+{
+public:
+    char name[16] { 0 };
+    gc_ptr<Father> father {}; // strong, the collector takes care of the cycle
+    Son(const char *nm)
+    {
+        strncpy(name, nm, 16);
+        cout << "created Son" << endl;
+    }
+    ~Son() { cout << "destoryed Son" << endl; }
+    void trace(GcTracer &t) { t(father); }
+};
+
+// a node of a ring, quiet so that many of them can be made
+struct Node
+{
+    vector<gc_ptr<Node>> next;
+    void trace(GcTracer &t) { t(next); }
+};
+
+// n nodes, each pointing at the next, the last one back at the first
+gc_ptr<Node> make_ring(int n)
+{
+    gc_ptr<Node> first = make_gc<Node>();
+    gc_ptr<Node> node = first;
+    for (int i = 1; i < n; i++)
+    {
+        node->next.push_back(make_gc<Node>());
+        node = node->next.back();
+    }
+    node->next.push_back(first);
+    return first;
+}
+
+int main()
+{
+    {
+        auto f = make_gc<Father>("father");
+        auto s = make_gc<Son>("son");
+
+        cout << "linked..." << endl;
+        f->son = s;
+        s->father = f;
+
+        cout << "f's ref count: " << f.use_count() << endl;
+        cout << "s's ref count: " << s.use_count() << endl;
+
+        cout << "collect while f and s are still in use, nothing goes" << endl;
+        cout << "freed " << gc_heap().collect() << endl;
+    }
+
+    cout << "f and s are gone, the Father and the Son only hold each other" << endl;
+    gc_heap().report(cout);
+    cout << "freed " << gc_heap().collect() << endl;
+    gc_heap().report(cout);
+
+    // a ring still in use next to rings that aren't
+    gc_ptr<Node> kept = make_ring(3);
+    for (int i = 0; i < 1000; i++)
+        make_ring(10);
+    cout << "live " << gc_heap().live() << ", candidates " << gc_heap().candidates() << endl;
+
+    // bounded pauses: 100 candidates per call
+    size_t calls = 0;
+    while (gc_heap().candidates() > 0)
+    {
+        gc_heap().collect(100);
+        calls++;
+    }
+    cout << calls << " calls, live " << gc_heap().live() << endl;
+
+    // or let it collect by itself as candidates come in
+    gc_heap().set_auto_collect(256, 64);
+    for (int i = 0; i < 1000; i++)
+        make_ring(10);
+    cout << "with auto collect: live " << gc_heap().live() << ", candidates " << gc_heap().candidates() << endl;
+    gc_heap().collect();
+    cout << "live " << gc_heap().live() << ", freed by the collector " << gc_heap().freed_by_collector() << endl;
+
+    // a long chain doesn't overflow the stack, the collector uses its own work list
+    make_ring(1000000);
+    cout << "freed " << gc_heap().collect() << " in one ring" << endl;
+
+    kept.reset();
+    gc_heap().collect();
+    cout << "live " << gc_heap().live() << endl;
+
+    return 0;
+}
@@ -0,0 +1,537 @@
+#ifndef GC_PTR_H_
+#define GC_PTR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// Reference counted pointer that also frees cycles.
+// cycle_shared_ptr.cpp shows a Father and a Son keeping each other alive
+// through shared_ptr forever. gc_ptr counts references the same way, so
+// most objects still go away the moment their count drops to 0, but it also
+// remembers every object whose count dropped without reaching 0: it might
+// now be held only by a cycle. collect() looks at those candidates with
+// trial deletion (Bacon and Rajan, "Concurrent Cycle Collection in Reference
+// Counted Systems", 2001):
+//   1. mark gray: from each candidate, subtract the references that come from
+//      inside the graph reachable from it
+//   2. scan: whatever still has a count above 0 is referenced from outside,
+//      so it and everything it reaches is live again; the rest turns white
+//   3. collect white: white objects are only referenced by each other, free them
+// To find the references, a class keeps its gc_ptr members visible with
+//     void trace(GcTracer &t) { t(son); t(friends); ... }
+// A class without trace is treated as holding no gc_ptrs.
+// When collect() frees a cycle it first sets every gc_ptr the garbage lists
+// in trace() to null and only then runs the destructors, since the objects
+// on the other end may already be gone. So a destructor of a class that can
+// end up in a cycle sees its traced gc_ptr members empty; it may touch its
+// other members, but must not count on reaching its neighbours.
+// Everything runs in the calling thread; don't use gc_ptr from more than one.
+
+class gc_ptr_base;
+template <class T>
+class gc_ptr;
+
+// calls a function on each gc_ptr an object lists in its trace()
+class GcTracer
+{
+private:
+    void (*visit_)(void *context, gc_ptr_base &p);
+    void *context_;
+
+public:
+    GcTracer(void (*visit)(void *, gc_ptr_base &), void *context) : visit_(visit), context_(context) {}
+
+    void operator()(gc_ptr_base &p) { visit_(context_, p); }
+    template <class Range>
+    auto operator()(Range &range) -> decltype(std::begin(range), void())
+    {
+        for (auto &p : range)
+            (*this)(p);
+    }
+};
+
+namespace gc_detail
+{
+enum class Color : unsigned char
+{
+    Black,  // in use
+    Gray,   // possible member of a garbage cycle
+    White,  // member of a garbage cycle
+    Purple  // possible root of a garbage cycle
+};
+
+template <class T, class = void>
+struct has_trace : std::false_type {};
+template <class T>
+struct has_trace<T, std::void_t<decltype(std::declval<T &>().trace(std::declval<GcTracer &>()))>> : std::true_type {};
+
+// header in front of every object made by make_gc
+struct GcObject
+{
+    long rc = 0;
+    Color color = Color::Black;
+    bool buffered = false;  // in the candidate list
+    bool destroyed = false; // object destroyed, the header waits for the candidate list to let go
+
+    virtual void trace(GcTracer &t) = 0;
+    virtual void destroy_object() noexcept = 0;
+    virtual const char *type_name() const noexcept = 0;
+    virtual const void *address() const noexcept = 0;
+    virtual ~GcObject() = default;
+};
+
+template <class T>
+struct GcBox : GcObject
+{
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    template <class... Args>
+    GcBox(Args &&... args) { ::new (static_cast<void *>(storage)) T(std::forward<Args>(args)...); }
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+
+    void trace(GcTracer &t) override
+    {
+        if constexpr (has_trace<T>::value)
+            get()->trace(t);
+    }
+    void destroy_object() noexcept override { get()->~T(); }
+    const char *type_name() const noexcept override { return typeid(T).name(); }
+    const void *address() const noexcept override { return storage; }
+};
+}
+
+// The candidate list and the collector.
+// There is one per program, gc_heap(). Besides collect() you can let it
+// collect by itself: once auto_threshold candidates have piled up, every new
+// candidate triggers a collect(auto_batch), so no single pause looks at more
+// than auto_batch candidates.
+class GcHeap
+{
+private:
+    typedef gc_detail::GcObject Object;
+    typedef gc_detail::Color Color;
+
+    std::deque<Object *> roots_; // candidates, oldest first; collect() takes from the front
+    std::vector<Object *> stack_; // work list, so long chains don't overflow the call stack
+    std::vector<Object *> children_;
+    size_t live_ = 0;
+    size_t freed_by_collector_ = 0;
+    size_t auto_threshold_ = 0; // 0: only collect when asked
+    size_t auto_batch_ = 0;
+    bool collecting_ = false;
+
+    void children(Object *s, std::vector<Object *> &out);
+    void free_box(Object *s) noexcept;
+    void release(Object *s) noexcept;
+    void possible_root(Object *s);
+
+    void mark_gray(Object *s);
+    void scan(Object *s);
+    void scan_black(Object *s);
+    void collect_white(Object *s, std::vector<Object *> &garbage);
+    void free_garbage(std::vector<Object *> &garbage);
+
+    friend class gc_ptr_base;
+    template <class T, class... Args>
+    friend gc_ptr<T> make_gc(Args &&... args);
+
+public:
+    GcHeap() = default;
+    GcHeap(const GcHeap &) = delete;
+    GcHeap &operator=(const GcHeap &) = delete;
+
+    // look at up to max_roots candidates, all of them by default; returns how many objects were freed
+    size_t collect(size_t max_roots = size_t(-1));
+    void set_auto_collect(size_t threshold, size_t batch)
+    {
+        auto_threshold_ = threshold;
+        auto_batch_ = batch;
+    }
+
+    size_t live() const { return live_; }
+    size_t candidates() const { return roots_.size(); }
+    size_t freed_by_collector() const { return freed_by_collector_; }
+
+    // Lists the garbage cycles collect() would free right now, one line per
+    // object, without freeing anything.
+    void report(std::ostream &os);
+};
+
+// never destroyed, gc_ptrs in other static objects may still need it at exit
+inline GcHeap &gc_heap()
+{
+    static GcHeap *heap = new GcHeap;
+    return *heap;
+}
+
+// the part of gc_ptr that doesn't depend on T, what GcTracer hands out
+class gc_ptr_base
+{
+protected:
+    gc_detail::GcObject *box_ = nullptr;
+
+    gc_ptr_base() = default;
+    explicit gc_ptr_base(gc_detail::GcObject *box) : box_(box)
+    {
+        if (box_)
+            increment(box_);
+    }
+    ~gc_ptr_base()
+    {
+        if (box_)
+            decrement(box_);
+    }
+
+    static void increment(gc_detail::GcObject *box)
+    {
+        box->rc++;
+        box->color = gc_detail::Color::Black;
+    }
+
+    static void decrement(gc_detail::GcObject *box)
+    {
+        if (--box->rc == 0)
+            gc_heap().release(box);
+        else
+            gc_heap().possible_root(box);
+    }
+
+    void assign(gc_detail::GcObject *box)
+    {
+        if (box)
+            increment(box);
+        gc_detail::GcObject *old = box_;
+        box_ = box;
+        if (old)
+            decrement(old);
+    }
+
+    friend class GcHeap;
+
+public:
+    long use_count() const { return box_ ? box_->rc : 0; }
+};
+
+template <class T>
+class gc_ptr : public gc_ptr_base
+{
+private:
+    T *ptr_ = nullptr;
+
+    template <class U>
+    friend class gc_ptr;
+    template <class U, class... Args>
+    friend gc_ptr<U> make_gc(Args &&... args);
+
+    gc_ptr(T *ptr, gc_detail::GcObject *box) : gc_ptr_base(box), ptr_(ptr) {}
+
+public:
+    gc_ptr() = default;
+    gc_ptr(std::nullptr_t) {}
+    gc_ptr(const gc_ptr &p) : gc_ptr_base(p.box_), ptr_(p.ptr_) {}
+    gc_ptr(gc_ptr &&p) noexcept : ptr_(p.ptr_)
+    {
+        box_ = p.box_;
+        p.box_ = nullptr;
+        p.ptr_ = nullptr;
+    }
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    gc_ptr(const gc_ptr<U> &p) : gc_ptr_base(p.box_), ptr_(p.ptr_) {}
+
+    gc_ptr &operator=(const gc_ptr &p)
+    {
+        T *ptr = p.ptr_;
+        assign(p.box_); // may free *this's old object, which may own p
+        ptr_ = ptr;
+        return *this;
+    }
+
+    gc_ptr &operator=(gc_ptr &&p)
+    {
+        if (this != &p)
+        {
+            gc_detail::GcObject *old = box_;
+            box_ = p.box_;
+            ptr_ = p.ptr_;
+            p.box_ = nullptr;
+            p.ptr_ = nullptr;
+            if (old)
+                decrement(old);
+        }
+        return *this;
+    }
+
+    gc_ptr &operator=(std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    void reset()
+    {
+        ptr_ = nullptr;
+        assign(nullptr);
+    }
+
+    T *get() const { return box_ ? ptr_ : nullptr; }
+    T &operator*() const { return *get(); }
+    T *operator->() const { return get(); }
+    explicit operator bool() const { return get() != nullptr; }
+};
+
+// construct a T managed by gc_heap()
+template <class T, class... Args>
+gc_ptr<T> make_gc(Args &&... args)
+{
+    auto *box = new gc_detail::GcBox<T>(std::forward<Args>(args)...);
+    gc_heap().live_++;
+    return gc_ptr<T>(box->get(), box);
+}
+
+inline void GcHeap::children(Object *s, std::vector<Object *> &out)
+{
+    out.clear();
+    GcTracer tracer([](void *context, gc_ptr_base &p) {
+        if (p.box_)
+            static_cast<std::vector<Object *> *>(context)->push_back(p.box_);
+    }, &out);
+    s->trace(tracer);
+}
+
+inline void GcHeap::free_box(Object *s) noexcept
+{
+    delete s;
+}
+
+// the count reached 0: destroy the object, which lets go of its children
+inline void GcHeap::release(Object *s) noexcept
+{
+    s->color = Color::Black;
+    s->destroy_object();
+    live_--;
+    if (s->buffered)
+        s->destroyed = true; // the candidate list still points at it, collect() frees it
+    else
+        free_box(s);
+}
+
+inline void GcHeap::possible_root(Object *s)
+{
+    if (s->color == Color::Purple)
+        return;
+    s->color = Color::Purple;
+    if (!s->buffered)
+    {
+        s->buffered = true;
+        roots_.push_back(s);
+        if (auto_threshold_ && roots_.size() >= auto_threshold_ && !collecting_)
+            collect(auto_batch_);
+    }
+}
+
+inline void GcHeap::mark_gray(Object *s)
+{
+    if (s->color == Color::Gray)
+        return;
+    s->color = Color::Gray;
+    stack_.push_back(s);
+    while (!stack_.empty())
+    {
+        Object *x = stack_.back();
+        stack_.pop_back();
+        children(x, children_);
+        for (Object *t : children_)
+        {
+            t->rc--; // the reference from x doesn't count
+            if (t->color != Color::Gray)
+            {
+                t->color = Color::Gray;
+                stack_.push_back(t);
+            }
+        }
+    }
+}
+
+inline void GcHeap::scan_black(Object *s)
+{
+    s->color = Color::Black;
+    stack_.push_back(s);
+    while (!stack_.empty())
+    {
+        Object *x = stack_.back();
+        stack_.pop_back();
+        children(x, children_);
+        for (Object *t : children_)
+        {
+            t->rc++; // give back what mark_gray took
+            if (t->color != Color::Black)
+            {
+                t->color = Color::Black;
+                stack_.push_back(t);
+            }
+        }
+    }
+}
+
+inline void GcHeap::scan(Object *s)
+{
+    std::vector<Object *> pending{s};
+    std::vector<Object *> kids;
+    while (!pending.empty())
+    {
+        Object *x = pending.back();
+        pending.pop_back();
+        if (x->color != Color::Gray)
+            continue;
+        if (x->rc > 0)
+            scan_black(x); // referenced from outside, x and all it reaches are live
+        else
+        {
+            x->color = Color::White;
+            children(x, kids);
+            pending.insert(pending.end(), kids.begin(), kids.end());
+        }
+    }
+}
+
+inline void GcHeap::collect_white(Object *s, std::vector<Object *> &garbage)
+{
+    std::vector<Object *> pending{s};
+    std::vector<Object *> kids;
+    while (!pending.empty())
+    {
+        Object *x = pending.back();
+        pending.pop_back();
+        if (x->color != Color::White)
+            continue;
+        x->color = Color::Black;
+        garbage.push_back(x);
+        children(x, kids);
+        pending.insert(pending.end(), kids.begin(), kids.end());
+    }
+}
+
+inline void GcHeap::free_garbage(std::vector<Object *> &garbage)
+{
+    // mark_gray already took every reference held by garbage off the count
+    // of its target, and nothing gave it back. Cut them before the
+    // destructors run, or live objects they point at are counted down twice.
+    for (Object *s : garbage)
+    {
+        GcTracer cut([](void *, gc_ptr_base &p) { p.box_ = nullptr; }, nullptr);
+        s->trace(cut);
+    }
+    for (Object *s : garbage)
+        s->destroy_object();
+    for (Object *s : garbage)
+    {
+        // a candidate waiting for a later collect() keeps its header until then
+        if (s->buffered)
+            s->destroyed = true;
+        else
+            free_box(s);
+    }
+    live_ -= garbage.size();
+    freed_by_collector_ += garbage.size();
+}
+
+inline size_t GcHeap::collect(size_t max_roots)
+{
+    if (collecting_)
+        return 0;
+    collecting_ = true;
+
+    // take the oldest candidates; new ones found meanwhile wait for the next call
+    size_t n = std::min(max_roots, roots_.size());
+    std::vector<Object *> roots(roots_.begin(), roots_.begin() + n);
+    roots_.erase(roots_.begin(), roots_.begin() + n);
+
+    // mark roots
+    std::vector<Object *> kept;
+    for (Object *s : roots)
+    {
+        if (s->color == Color::Purple && s->rc > 0)
+        {
+            mark_gray(s);
+            kept.push_back(s);
+        }
+        else
+        {
+            s->buffered = false;
+            if (s->destroyed)
+                free_box(s);
+        }
+    }
+    // scan roots
+    for (Object *s : kept)
+        scan(s);
+    // collect roots; unlike the paper all of this batch leaves the candidate
+    // list first, so garbage reached from here is freed even if it comes
+    // first in the list. Garbage that is a candidate of a later batch is
+    // freed too, only its header stays behind.
+    std::vector<Object *> garbage;
+    for (Object *s : kept)
+        s->buffered = false;
+    for (Object *s : kept)
+        collect_white(s, garbage);
+    free_garbage(garbage);
+
+    collecting_ = false;
+    return garbage.size();
+}
+
+inline void GcHeap::report(std::ostream &os)
+{
+    std::vector<Object *> kept;
+    for (Object *s : roots_)
+        if (s->color == Color::Purple && s->rc > 0)
+            kept.push_back(s);
+    for (Object *s : kept)
+        mark_gray(s);
+    for (Object *s : kept)
+        scan(s);
+
+    // each white group reachable from one root is one garbage cycle (or a few joined ones)
+    size_t cycles = 0, objects = 0;
+    std::vector<Object *> pending, kids, whites;
+    for (Object *s : kept)
+    {
+        if (s->color != Color::White)
+            continue;
+        whites.clear();
+        pending.assign(1, s);
+        while (!pending.empty())
+        {
+            Object *x = pending.back();
+            pending.pop_back();
+            if (x->color != Color::White)
+                continue;
+            x->color = Color::Gray; // seen, scan_black below makes it black again
+            whites.push_back(x);
+            children(x, kids);
+            pending.insert(pending.end(), kids.begin(), kids.end());
+        }
+        os << "cycle " << ++cycles << ": " << whites.size() << " object(s)\n";
+        for (Object *x : whites)
+            os << "  " << x->type_name() << " at " << x->address() << '\n';
+        objects += whites.size();
+    }
+    os << cycles << " uncollected cycle(s), " << objects << " of " << live_ << " live object(s)\n";
+
+    // undo the trial deletion; the candidates stay candidates
+    for (Object *s : kept)
+        if (s->color != Color::Black)
+            scan_black(s);
+    for (Object *s : kept)
+        s->color = Color::Purple;
+}
+
+#endif
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <cstring>
+
+#include "local_shared_ptr.hpp"
+
+using namespace std;
+
+class Father;
+class Son;
+
+class Father
+{
+public:
+    char name[16] { 0 };
+    local_shared_ptr<Son> son {};
+    Father(const char *nm)
+    {
+        strncpy(name, nm, 16);
+        cout << "created Father" << endl;
+    }
+    ~Father() { cout << "destoryed Father" << endl; }
+};
+
+class Son
+{
+public:
+    char name[16] { 0 };
+    local_weak_ptr<Father> father {}; // weak, or the two would keep each other alive
+    Son(const char *nm)
+    {
+        strncpy(name, nm, 16);
+        cout << "created Son" << endl;
+    }
+    ~Son() { cout << "destoryed Son" << endl; }
+};
+
+int main()
+{
+    auto f = make_local_shared<Father>("father");
+    auto s = make_local_shared<Son>("son");
+
+    cout << "f's ref count: " << f.use_count() << endl;
+    cout << "s's ref count: " << s.use_count() << endl;
+
+    cout << "linked..." << endl;
+    f->son = s;
+    s->father = f;
+
+    cout << "f's ref count: " << f.use_count() << endl;
+    cout << "s's ref count: " << s.use_count() << endl;
+
+    if (auto father = s->father.lock())
+        cout << s->name << "'s father is " << father->name << endl;
+
+    cout << "drop f, the Father goes and the Son's weak pointer expires" << endl;
+    f.reset();
+    cout << "s->father expired: " << s->father.expired() << endl;
+
+    local_shared_ptr<int> p(new int(12)); // separate allocation, deleted with delete
+    local_shared_ptr<int> q = p;
+    cout << "*q = " << *q << ", use count " << q.use_count() << endl;
+
+    return 0;
+}
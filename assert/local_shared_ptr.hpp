@@ -0,0 +1,302 @@
+#ifndef LOCAL_SHARED_PTR_H_
+#define LOCAL_SHARED_PTR_H_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// shared_ptr and weak_ptr for objects that never leave one thread.
+// std::shared_ptr changes its counts with atomic instructions, so that
+// copies in different threads can't race. Here the counts are plain longs,
+// which makes every copy and every destruction a normal increment or
+// decrement. Everything else works like the std versions:
+//     local_shared_ptr<T> p = make_local_shared<T>(args...);  // object and counts in one allocation
+//     local_weak_ptr<T> w = p;
+//     if (auto q = w.lock()) ...
+// Never share one of these between threads, not even a copy of one.
+
+namespace local_ptr_detail
+{
+// The counts, and how to get rid of the object and of the block itself.
+// weak counts the local_weak_ptrs plus one for all the local_shared_ptrs
+// together, so the block goes away when the last pointer of either kind does.
+struct ControlBlock
+{
+    long shared = 1;
+    long weak = 1;
+
+    virtual void dispose() noexcept = 0; // destroy the object
+    virtual void destroy() noexcept = 0; // free the block
+    virtual ~ControlBlock() = default;
+
+    void release_shared() noexcept
+    {
+        if (--shared == 0)
+        {
+            dispose();
+            release_weak();
+        }
+    }
+
+    void release_weak() noexcept
+    {
+        if (--weak == 0)
+            destroy();
+    }
+};
+
+// object allocated by the caller, freed with a deleter
+template <class T, class D>
+struct PointerBlock : ControlBlock
+{
+    T *ptr;
+    D deleter;
+
+    PointerBlock(T *p, D d) : ptr(p), deleter(std::move(d)) {}
+    void dispose() noexcept override { deleter(ptr); }
+    void destroy() noexcept override { delete this; }
+};
+
+// object living inside the block, what make_local_shared creates
+template <class T>
+struct InplaceBlock : ControlBlock
+{
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    template <class... Args>
+    InplaceBlock(Args &&... args) { ::new (static_cast<void *>(storage)) T(std::forward<Args>(args)...); }
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    void dispose() noexcept override { get()->~T(); }
+    void destroy() noexcept override { delete this; }
+};
+}
+
+template <class T>
+class local_weak_ptr;
+
+template <class T>
+class local_shared_ptr
+{
+private:
+    T *ptr_ = nullptr;
+    local_ptr_detail::ControlBlock *block_ = nullptr;
+
+    template <class U>
+    friend class local_shared_ptr;
+    template <class U>
+    friend class local_weak_ptr;
+    template <class U, class... Args>
+    friend local_shared_ptr<U> make_local_shared(Args &&... args);
+
+    struct adopt_tag {};
+
+    // takes over a reference the caller already counted
+    local_shared_ptr(adopt_tag, T *ptr, local_ptr_detail::ControlBlock *block) noexcept : ptr_(ptr), block_(block) {}
+
+public:
+    typedef T element_type;
+
+    constexpr local_shared_ptr() noexcept = default;
+    constexpr local_shared_ptr(std::nullptr_t) noexcept {}
+
+    template <class U>
+    explicit local_shared_ptr(U *p) : local_shared_ptr(p, std::default_delete<U>()) {}
+
+    template <class U, class D>
+    local_shared_ptr(U *p, D d)
+    {
+        try
+        {
+            block_ = new local_ptr_detail::PointerBlock<U, D>(p, d);
+        }
+        catch (...)
+        {
+            d(p); // like std::shared_ptr, don't leak p when the block can't be allocated
+            throw;
+        }
+        ptr_ = p;
+    }
+
+    local_shared_ptr(const local_shared_ptr &p) noexcept : ptr_(p.ptr_), block_(p.block_)
+    {
+        if (block_)
+            block_->shared++;
+    }
+
+    local_shared_ptr(local_shared_ptr &&p) noexcept : ptr_(p.ptr_), block_(p.block_)
+    {
+        p.ptr_ = nullptr;
+        p.block_ = nullptr;
+    }
+
+    // from a pointer to a derived class
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    local_shared_ptr(const local_shared_ptr<U> &p) noexcept : ptr_(p.ptr_), block_(p.block_)
+    {
+        if (block_)
+            block_->shared++;
+    }
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    local_shared_ptr(local_shared_ptr<U> &&p) noexcept : ptr_(p.ptr_), block_(p.block_)
+    {
+        p.ptr_ = nullptr;
+        p.block_ = nullptr;
+    }
+
+    // aliasing: shares ownership with p but points at ptr, e.g. a member of *p
+    template <class U>
+    local_shared_ptr(const local_shared_ptr<U> &p, T *ptr) noexcept : ptr_(ptr), block_(p.block_)
+    {
+        if (block_)
+            block_->shared++;
+    }
+
+    ~local_shared_ptr()
+    {
+        if (block_)
+            block_->release_shared();
+    }
+
+    local_shared_ptr &operator=(const local_shared_ptr &p) noexcept
+    {
+        local_shared_ptr(p).swap(*this);
+        return *this;
+    }
+
+    local_shared_ptr &operator=(local_shared_ptr &&p) noexcept
+    {
+        local_shared_ptr(std::move(p)).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { local_shared_ptr().swap(*this); }
+    template <class U>
+    void reset(U *p) { local_shared_ptr(p).swap(*this); }
+
+    void swap(local_shared_ptr &p) noexcept
+    {
+        std::swap(ptr_, p.ptr_);
+        std::swap(block_, p.block_);
+    }
+
+    T *get() const noexcept { return ptr_; }
+    T &operator*() const noexcept { return *ptr_; }
+    T *operator->() const noexcept { return ptr_; }
+    long use_count() const noexcept { return block_ ? block_->shared : 0; }
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+};
+
+template <class T>
+class local_weak_ptr
+{
+private:
+    T *ptr_ = nullptr;
+    local_ptr_detail::ControlBlock *block_ = nullptr;
+
+    template <class U>
+    friend class local_weak_ptr;
+
+public:
+    constexpr local_weak_ptr() noexcept = default;
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    local_weak_ptr(const local_shared_ptr<U> &p) noexcept : ptr_(p.ptr_), block_(p.block_)
+    {
+        if (block_)
+            block_->weak++;
+    }
+
+    local_weak_ptr(const local_weak_ptr &w) noexcept : ptr_(w.ptr_), block_(w.block_)
+    {
+        if (block_)
+            block_->weak++;
+    }
+
+    local_weak_ptr(local_weak_ptr &&w) noexcept : ptr_(w.ptr_), block_(w.block_)
+    {
+        w.ptr_ = nullptr;
+        w.block_ = nullptr;
+    }
+
+    ~local_weak_ptr()
+    {
+        if (block_)
+            block_->release_weak();
+    }
+
+    local_weak_ptr &operator=(const local_weak_ptr &w) noexcept
+    {
+        local_weak_ptr(w).swap(*this);
+        return *this;
+    }
+
+    local_weak_ptr &operator=(local_weak_ptr &&w) noexcept
+    {
+        local_weak_ptr(std::move(w)).swap(*this);
+        return *this;
+    }
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    local_weak_ptr &operator=(const local_shared_ptr<U> &p) noexcept
+    {
+        local_weak_ptr(p).swap(*this);
+        return *this;
+    }
+
+    void reset() noexcept { local_weak_ptr().swap(*this); }
+
+    void swap(local_weak_ptr &w) noexcept
+    {
+        std::swap(ptr_, w.ptr_);
+        std::swap(block_, w.block_);
+    }
+
+    long use_count() const noexcept { return block_ ? block_->shared : 0; }
+    bool expired() const noexcept { return use_count() == 0; }
+
+    // a local_shared_ptr to the object, or an empty one if it is gone
+    local_shared_ptr<T> lock() const noexcept
+    {
+        if (expired())
+            return local_shared_ptr<T>();
+        block_->shared++;
+        return local_shared_ptr<T>(typename local_shared_ptr<T>::adopt_tag(), ptr_, block_);
+    }
+};
+
+// one allocation for the counts and the object, like std::make_shared
+template <class T, class... Args>
+local_shared_ptr<T> make_local_shared(Args &&... args)
+{
+    auto *block = new local_ptr_detail::InplaceBlock<T>(std::forward<Args>(args)...);
+    return local_shared_ptr<T>(typename local_shared_ptr<T>::adopt_tag(), block->get(), block);
+}
+
+template <class T, class U>
+bool operator==(const local_shared_ptr<T> &a, const local_shared_ptr<U> &b) noexcept
+{
+    return a.get() == b.get();
+}
+
+template <class T, class U>
+bool operator!=(const local_shared_ptr<T> &a, const local_shared_ptr<U> &b) noexcept
+{
+    return a.get() != b.get();
+}
+
+template <class T>
+bool operator==(const local_shared_ptr<T> &a, std::nullptr_t) noexcept
+{
+    return !a;
+}
+
+template <class T>
+bool operator!=(const local_shared_ptr<T> &a, std::nullptr_t) noexcept
+{
+    return static_cast<bool>(a);
+}
+
+#endif
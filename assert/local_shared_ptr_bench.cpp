@@ -0,0 +1,87 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "local_shared_ptr.hpp"
+
+using namespace std;
+
+// the Father/Son graph from break_cycle_shared.cpp, for either kind of pointer
+template <template <class> class Shared, template <class> class Weak>
+struct Graph
+{
+    struct Son;
+    struct Father
+    {
+        int id;
+        vector<Shared<Son>> sons;
+        explicit Father(int i) : id(i) {}
+    };
+    struct Son
+    {
+        int id;
+        Weak<Father> father;
+        explicit Son(int i) : id(i) {}
+    };
+};
+
+template <class T> using std_shared = shared_ptr<T>;
+template <class T> using std_weak = weak_ptr<T>;
+
+template <class Begin>
+double ms_since(Begin begin)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+template <template <class> class Shared, template <class> class Weak, class Make>
+void run(const char *name, Make make)
+{
+    using G = Graph<Shared, Weak>;
+    const int fathers = 200000, sons = 4;
+
+    auto begin = chrono::steady_clock::now();
+    vector<Shared<typename G::Father>> all;
+    all.reserve(fathers);
+    for (int i = 0; i < fathers; i++)
+    {
+        auto f = make.template operator()<typename G::Father>(i);
+        for (int j = 0; j < sons; j++)
+        {
+            auto s = make.template operator()<typename G::Son>(j);
+            s->father = f;
+            f->sons.push_back(s);
+        }
+        all.push_back(f);
+    }
+    double build = ms_since(begin);
+
+    // walk the graph the way building code does, copying pointers around;
+    // no allocation here, only reference counting
+    begin = chrono::steady_clock::now();
+    long check = 0;
+    for (int round = 0; round < 20; round++)
+        for (auto f : all)
+            for (auto s : f->sons)
+                if (auto father = s->father.lock())
+                    check += father->id + s.use_count();
+    double walk = ms_since(begin);
+
+    begin = chrono::steady_clock::now();
+    all.clear();
+    double destroy = ms_since(begin);
+
+    cout << name << ": build " << build << " ms, walk " << walk << " ms, free " << destroy
+         << " ms (" << check << ")" << endl;
+}
+
+int main()
+{
+    cout << "200000 fathers with 4 sons each; the walk copies and locks pointers 20 times over" << endl;
+    run<std_shared, std_weak>("std::shared_ptr", []<class T>(int i) { return make_shared<T>(i); });
+    run<local_shared_ptr, local_weak_ptr>("local_shared_ptr", []<class T>(int i) { return make_local_shared<T>(i); });
+    run<std_shared, std_weak>("std::shared_ptr", []<class T>(int i) { return make_shared<T>(i); });
+    run<local_shared_ptr, local_weak_ptr>("local_shared_ptr", []<class T>(int i) { return make_local_shared<T>(i); });
+    return 0;
+}
@@ -0,0 +1,1055 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef MEMORY_POOL_STATS
+#include <ostream>
+#define POOL_STAT(stmt) stmt
+#else
+#define POOL_STAT(stmt)
+#endif
+
+#ifdef MEMORY_POOL_DEBUG
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#define POOL_DEBUG(stmt) stmt
+#else
+#define POOL_DEBUG(stmt)
+#endif
+
+#if defined(__SANITIZE_ADDRESS__)
+#define MEMORY_POOL_ASAN
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MEMORY_POOL_ASAN
+#endif
+#endif
+
+#ifdef MEMORY_POOL_ASAN
+#include <sanitizer/asan_interface.h>
+#define POOL_POISON(addr, size) ASAN_POISON_MEMORY_REGION(addr, size)
+#define POOL_UNPOISON(addr, size) ASAN_UNPOISON_MEMORY_REGION(addr, size)
+#else
+#define POOL_POISON(addr, size) ((void)(addr), (void)(size))
+#define POOL_UNPOISON(addr, size) ((void)(addr), (void)(size))
+#endif
+
+/*
+*	这个是内存分配器或者说是内存池
+*	主要用于模拟原生的new和delete运算符
+*	
+*	因为如果对于某一类型的对象进行大量的内存操作, 比如说销毁和创建, 
+*	如果只使用原生的, 那么会容易造成内存碎片的问题, 从而降低程序性能
+*	甚至会造成程序崩溃.
+*	
+*	而解决策略就是创建一个内存池, 这个内存池向系统申请一大块内存
+*	然后我们如果要申请内存操作对象时, 就向内存池申请内存
+*	然后我们不再使用这个对象, 就把这个对象的内存归还给内存池, 以备之后再利用
+*	如果内存池已满, 就再申请一大块内存.
+*	以空间换时间的策略,来避免内存碎片的问题, 也大大提高内存分配效率
+* 
+*	总之, 内存池就是个管家一样的存在, 我们不直接接触系统申请内存, 而是让内存池代理这个操作.
+* 
+*		
+*	这个内存分配器主要针对单个对象的内存分配.
+*	不过也提供了allocate(n)和deallocate(ptr, n)这一对批量接口, 一次分配一段连续的n个对象的内存,
+*	这样成批创建对象时就不用一个个调用allocate了, 同时也可以用来支持对象数组.
+*	文件末尾的PoolAllocator就是在此基础上包装出来的符合标准库要求的分配器, 可以给std::vector, std::list, std::map使用.
+*	
+*	这个分配器的思路是首先申请一大片内存
+*	然后根据目标类型分块
+*	注意此时的各个分块是未被初始化, 或者说构造的
+*	我们内存池将内存分配跟对象构造分离开来, 以支持给更加细粒度的操作
+* 
+*	当我们内存池满了后, 就开辟出新的内存大块, 而这个内存大块与之前的内存大块其实也是用链表管理的, 新的内存大块被放在表头
+*	这个内存块的开头第一个分块是用作指针, 以指向下一个内存块
+*	当我们向内存池new一个对象时, 内存池就取出第二个分块, 分配给这个对象, 然后再调用定点构造器, 原地构造出指定对象
+*	
+*	而我们释放这个对象时, 并没有真正将这个对象所占有的内存还回给系统, 而是还回给内存池, 而内存池将这个归还回来的内存分块连接到一个链表的表头
+*	当我们再次向内存池new一个对象时, 就查看这个链表到底空不空, 如果不空则取出这个链表的第一个分块构造返回给用户, 否则就向这个大内存块取出分块构造.
+* 
+*	当然, 我们释放这个对象也是分步进行的, 第一步就是调用destroy, 触发这个对象自己的析构函数, 用来释放这个对象自己所管理的内存,
+*	然后再调用deallocate, 归还这个分块.
+*	当然如果这个对象并没有管理资源, 也可以不用调用这个对象的析构函数, 直接归还分块
+*	
+*	值得注意的是, 我们所维护的节点是个共用体, 既可以储存对象数据, 也可以用作指针指向下一个分块
+*	为什么不将这个节点用包含数据和指针两个成员的结构表示节点, 而用共用体呢?
+*	因为, 共用体节省内存大小, 并且我们发现, 当我们未使用分块节点或者被放在回收链表时, 其实里面的数据是无用的, 所以干脆就可以把这个节点当作指针来用
+*	而当我们要使用这个节点是, 里面的数据被构造出来, 此时就被当作数据本身.
+*	数据和指针的使用时机本身是错开的, 因此用共用体就再合适不过了.
+*	
+*	批量分配时, 连续的一段内存只能从当前内存块_currentNode到_lastNode之间切出来, 因为回收链表里的节点并不是连续的.
+*	所以只有n个对象正好占一个节点时才会去回收链表里拿, 否则当前内存块剩下的不够, 就把剩下的节点挂到回收链表上, 再申请新的内存块.
+*	注意节点的大小是sizeof(_Node), 可能比sizeof(T)大(比如T是int而指针是8个字节), 所以n个对象占用的节点数要按字节数向上取整.
+*	如果n个对象一个内存块都装不下, 就直接向BlockSource申请, 释放时也根据n还给BlockSource.
+*	批量释放时把这段内存重新切成节点, 先串成一条链表, 再整条接到回收链表的表头.
+*	
+*	原来内存大块一旦申请了, 只有在内存池析构时才会还给系统, 一次流量高峰就会让常驻内存永远涨上去.
+*	所以这里加了trim()和shrink_to_fit()来回收内存大块:
+*	trim()会统计每个内存块里还有多少个活着的对象(已切分的节点数减去在回收链表里的节点数),
+*	完全空闲的内存块就从内存块链表和回收链表里摘出来, 先放进备用链表(最多留maxSpare个), 多的就还给系统.
+*	以后再需要内存块时, allocateBlock()优先从备用链表里拿, 这样不会反复向系统申请和释放.
+*	shrink_to_fit()在trim()之后连备用链表也一起还给系统.
+*	
+*	这个统计只在trim()的时候做, allocate和deallocate只多维护一个回收链表长度的计数, 快速路径基本不受影响.
+*	统计时先把回收链表和内存块链表都按地址归并排序, 这样每个内存块的空闲节点在回收链表里正好是连续的一段,
+*	两条链表并排走一遍就数完了. 排序只改节点里的next指针, 不申请任何内存,
+*	所以deallocate里自动触发的trim()不会因为内存不足而抛出异常.
+*	如果通过setTrimPolicy()设置了高水位, 回收链表的长度超过高水位时, deallocate会自动调用一次trim().
+*	为了避免每次deallocate都白白做一次trim(), 如果trim()之后回收链表还是很长, 下一次触发的门槛会翻倍.
+*	
+*	construct和newObject的参数是转发引用(Args&&...), 用std::forward原样转发给构造函数,
+*	这样右值参数会被移动而不是复制, std::unique_ptr这种只能移动的类型也能在内存池里构造了.
+*	如果构造函数抛出了异常, newObject会先把刚分配的节点还回去再继续抛出, 不会漏掉这个节点.
+*	
+*	文件末尾还有一个pool_unique_ptr<T, Size>, 它是带着PoolDeleter的std::unique_ptr,
+*	删除器记住了所属的内存池, 智能指针析构时对象会被还给这个内存池而不是delete掉.
+*	用makePoolUnique(pool, args...)来创建.
+*	
+*	如果在包含这个头文件之前定义了MEMORY_POOL_STATS宏, 内存池还会记录运行时的统计数据:
+*	内存块的个数, 活着的节点数和它的峰值, 从回收链表拿到节点的次数和从内存块切分的次数(命中率), 批量和超大分配的次数,
+*	还有一个分配突发长度的直方图, 也就是两次回收之间连续分配了多少个节点, 按2的幂分桶.
+*	这些数据可以通过stats()拿到, 也可以用dumpStats()输出, 方便根据实际情况调整Size.
+*	没有定义这个宏时, 所有统计语句都被POOL_STAT宏展开成空的, 内存池里也没有统计成员, 没有任何额外开销.
+*	
+*	节点默认只按T本身的要求对齐, 而第三个模板参数Align可以把节点的对齐提高到16, 32, 64字节,
+*	这样SIMD类型就能放心地用对齐的load/store指令.
+*	对齐是加在共用体节点上的, 所以节点的大小也会被补齐成Align的倍数,
+*	Align取CacheLineSize时每个节点独占一个缓存行, 相邻节点被不同线程使用时就不会有伪共享(false sharing).
+*	当然, 节点越大, 一个内存块能装的节点就越少.
+*	
+*	第四个模板参数BlockSource决定内存块从哪里来, 它只要提供allocate(bytes, align)和deallocate(ptr, bytes, align)两个静态函数.
+*	默认的NewBlockSource用带对齐参数的operator new.
+*	MmapBlockSource直接向操作系统mmap, 当一次申请不少于HugePageSize时, 会把地址按大页对齐, 再用madvise请求透明大页,
+*	对于Size很大的内存池, 一个大页就能覆盖原来512个普通页, TLB就不会被挤爆了.
+*	
+*	deallocate本身是不做任何检查的, 重复释放会让回收链表出现环, 把别的内存池的指针还回来会把两个内存池都搞坏,
+*	而这些错误往往要过很久才会以莫名其妙的方式表现出来.
+*	所以定义了MEMORY_POOL_DEBUG宏之后, 内存池会进入检查模式:
+*		每个分配出去的指针都记在一张表里, 释放时查不到这个指针, 就看它是不是落在本内存池的内存块里,
+*		是的话就是重复释放, 不是的话就是别的内存池(或者根本不是内存池)的指针, 都会立即报错并abort.
+*		回收的节点除了开头的next指针以外都填上0xDD, 再次分配时检查一下, 被改过说明有人在释放之后还在写这个对象.
+*		内存池析构时表里还有指针, 就说明有对象泄漏了, 会把它们的地址打印出来.
+*	另外, 如果是用AddressSanitizer编译的, 还没切分的节点和回收链表里节点的数据部分都会被标记成不可访问,
+*	释放之后再读写对象, ASan会直接指出是哪一行代码.
+*	没有定义这个宏也没有开ASan时, 这些检查都被宏展开成空的, 没有任何额外开销.
+*/
+
+// 缓存行的大小, 大部分x86和ARM处理器都是64字节
+constexpr size_t CacheLineSize = 64;
+
+// 默认的内存块来源, 带对齐参数的operator new
+struct NewBlockSource
+{
+	static void* allocate(size_t bytes, size_t align)
+	{
+		return operator new(bytes, std::align_val_t(align));
+	}
+
+	static void deallocate(void* _ptr, size_t, size_t align) noexcept
+	{
+		operator delete(_ptr, std::align_val_t(align));
+	}
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// 直接向操作系统mmap内存块, 足够大时请求透明大页
+// mmap返回的地址是按页对齐的, 所以不超过一页的对齐要求都是满足的
+struct MmapBlockSource
+{
+	static constexpr size_t HugePageSize = size_t(2) << 20;	// 2MB
+
+	static void* allocate(size_t bytes, size_t align)
+	{
+		// munmap的地址必须按页对齐, 下面切掉尾巴时用的是aligned + bytes, 所以bytes要先取整到页
+		if (bytes > size_t(-1) - 2 * HugePageSize)
+			throw std::bad_alloc();
+		bytes = roundToPage(bytes);
+		if (bytes < HugePageSize)
+			return map(bytes);
+
+		// 多映射一个大页的长度, 然后把首尾多出来的部分还回去, 剩下的就是按大页对齐的
+		char* raw = static_cast<char*>(map(bytes + HugePageSize));
+		std::uintptr_t address = reinterpret_cast<std::uintptr_t>(raw);
+		char* aligned = raw + (HugePageSize - address % HugePageSize) % HugePageSize;
+		if (aligned > raw)
+			munmap(raw, aligned - raw);
+		munmap(aligned + bytes, raw + bytes + HugePageSize - (aligned + bytes));
+#ifdef MADV_HUGEPAGE
+		madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+		(void)align;
+		return aligned;
+	}
+
+	// 按allocate同样的方式取整, 保证释放的就是当初映射的那些页
+	static void deallocate(void* _ptr, size_t bytes, size_t) noexcept
+	{
+		munmap(_ptr, roundToPage(bytes));
+	}
+
+private:
+	static size_t roundToPage(size_t bytes) noexcept
+	{
+		static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return (bytes + page - 1) / page * page;
+	}
+
+	static void* map(size_t bytes)
+	{
+		void* result = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (result == MAP_FAILED)
+			throw std::bad_alloc();
+		return result;
+	}
+};
+#endif
+
+
+template <typename T, size_t Size = 1024, size_t Align = alignof(T), typename BlockSource = NewBlockSource>
+class Allocator
+{
+public:
+	// 重定义类型
+	using value_type = T;
+	using pointer = T*;
+	using reference = T&;
+	using const_pointer = const T*;
+	using const_reference = const T&;
+	using size_type = size_t;
+	using difference_type = ptrdiff_t;
+	
+	// 自指
+	using self_ = Allocator<T, Size, Align, BlockSource>;
+	using self_reference = Allocator<T, Size, Align, BlockSource>&;
+
+	static_assert(Align && (Align & (Align - 1)) == 0, "Alignment must be a power of two.");
+
+	// 节点真正的对齐, 不能比T和指针本身的要求还低
+	static constexpr size_type NodeAlign = std::max({ Align, alignof(T), alignof(void*) });
+
+private:
+	// 节点单元
+	// 是个共用体, 在未使用时, 当作指针, 当被构造完成时, 则为数据单元
+	union alignas(NodeAlign) _Node
+	{
+		value_type data;
+		_Node* next;
+	};
+
+	// 私有重定义类型
+	using raw_pointer = char*;  // 未使用具体化时的内存块单位是char
+	using node_type = _Node;
+	using node_pointer = _Node*;
+
+	//私有成员 都是_Node指针
+	node_pointer _currentBlock = nullptr;
+	node_pointer _currentNode = nullptr;
+	node_pointer _lastNode = nullptr;
+	node_pointer _freeNode = nullptr;
+	node_pointer _spareBlock = nullptr;	// 备用内存块链表, 里面的内存块是完全空闲的
+
+	// 回收策略相关的计数
+	size_type _freeCount = 0;	// 回收链表的长度
+	size_type _spareCount = 0;	// 备用内存块的个数
+	size_type _maxSpare = 0;	// 最多保留多少个备用内存块
+	size_type _highWater = 0;	// 回收链表的高水位, 为0时不自动trim
+	size_type _trimAt = 0;		// 下一次自动trim的门槛
+	
+	// 申请内存块的函数
+	void allocateBlock() noexcept;
+
+	// n个对象所占用的节点个数
+	static constexpr size_type nodesFor(size_type n) noexcept;
+
+	// 把用next串起来的链表按地址从小到大排序, 返回新的表头
+	static node_pointer sortByAddress(node_pointer head) noexcept;
+
+	// 节点进入回收链表, 数据部分填上0xDD并交给ASan标记成不可访问
+	static void markFree(node_pointer node) noexcept;
+	// 节点从回收链表里取出来, 检查数据部分有没有被改过
+	static void markReused(node_pointer node) noexcept;
+
+#ifdef MEMORY_POOL_DEBUG
+	static constexpr unsigned char FreePattern = 0xDD;
+
+	// 所有分配出去的指针, 以及分配时的对象个数
+	std::unordered_map<const void*, size_type> _live;
+
+	// 检查_ptr是不是本内存池分配出去的n个对象
+	void checkLive(const void* _ptr, size_type n) const noexcept;
+	// _ptr是否落在本内存池的某个节点上
+	bool owns(const void* _ptr) const noexcept;
+	// 打印泄漏的对象
+	void reportLeaks() const noexcept;
+	[[noreturn]] static void poolError(const char* message, const void* _ptr) noexcept;
+#endif
+
+public:
+
+#ifdef MEMORY_POOL_STATS
+	static constexpr size_type BurstBuckets = 16;	// 突发长度直方图的桶数, 第i个桶是[2^i, 2^(i+1))
+
+	// 统计数据
+	struct PoolStats
+	{
+		size_type blocks = 0;				// 内存块链表里的内存块个数
+		size_type allocations = 0;			// allocate的调用次数
+		size_type deallocations = 0;		// deallocate的调用次数
+		size_type freeListHits = 0;			// 从回收链表拿到的节点数
+		size_type freshNodes = 0;			// 从内存块切分出来的节点数
+		size_type bulkAllocations = 0;		// 批量分配的次数
+		size_type largeAllocations = 0;		// 超过一个内存块, 直接向系统申请的次数
+		size_type liveNodes = 0;			// 活着的节点数
+		size_type peakLiveNodes = 0;		// 活着的节点数的峰值
+		size_type trims = 0;				// trim的次数
+		size_type releasedBlocks = 0;		// trim回收的内存块个数
+		size_type currentBurst = 0;			// 当前这一次突发已经连续分配的节点数
+		size_type burstHistogram[BurstBuckets] = {};
+	};
+
+private:
+	PoolStats _stats;
+
+	// 记录分配了count个节点
+	void recordAllocation(size_type count) noexcept;
+	// 记录回收了count个节点, 同时结束当前的突发
+	void recordDeallocation(size_type count) noexcept;
+
+public:
+	const PoolStats& stats() const noexcept { return _stats; }
+	// 把统计数据输出到os
+	void dumpStats(std::ostream& os) const;
+#endif
+
+	// 内存块的大小必须要至少是节点大小的两倍
+	static_assert(Size >= 2 * sizeof(node_type), "Block size is too small.");
+
+
+	static constexpr size_type Num = Size / sizeof(node_type) - 1;  // 每个内存块所能储存的节点的个数
+	static constexpr size_type MaxNum = Num * size_type(-1);   // 这个分配器所能够储存的最大节点数
+
+	// allocate(n)一次最多能分配的对象个数, 再多的话n个对象的字节数向上取整到节点时就溢出了
+	static constexpr size_type max_size() noexcept
+	{
+		return (size_type(-1) - sizeof(node_type)) / sizeof(value_type);
+	}
+
+	Allocator() noexcept = default; //采用默认构造函数, 四个私有成员的值都是nullptr
+	Allocator(Allocator&& other_alloc) noexcept; // 允许移动构造函数
+
+	// 禁止复制构造函数和赋值运算符函数
+	Allocator(const Allocator&) = delete;
+	Allocator& operator=(const Allocator&) = delete;
+	Allocator& operator=(Allocator&&) = delete;
+
+	//析构函数, 要用来释放这个内存分配器的内存
+	~Allocator() noexcept;
+
+public:
+
+	// 下面是暴露出来的公有接口
+
+	//取地址函数
+	pointer address(reference _ref) const noexcept;
+	const_pointer address(const_reference _cref) const noexcept;
+
+	//分配和回收节点
+	pointer allocate() noexcept;
+	void deallocate(pointer _ptr);
+
+	// 批量分配和回收, 一次处理连续的n个对象, n超过max_size()时抛出std::bad_array_new_length
+	pointer allocate(size_type n);
+	void deallocate(pointer _ptr, size_type n);
+
+	// 回收完全空闲的内存块, 返回回收的内存块个数
+	size_type trim() noexcept;
+	// trim之后把备用内存块也全部还给系统
+	void shrink_to_fit() noexcept;
+	// 设置回收策略, highWater为回收链表的高水位(节点数, 0表示不自动trim), maxSpare为最多保留的备用内存块个数
+	void setTrimPolicy(size_type highWater, size_type maxSpare = 0) noexcept;
+
+	//在指定节点构造对象
+	template<typename... Args>
+	pointer construct(pointer _ptr, Args &&... args);
+	// 在指定地点释放这个节点对象所管理的内存, 
+	// 如果这个对象并没有管理堆内存, 其实也可以不用这个函数, 直接调用deallocate回收节点就行了
+	void destroy(pointer _ptr);
+
+	// 一步到位模拟new运算符
+	template<typename... Args>
+	pointer newObject(Args && ...args);
+
+	// 一步到位模拟delete运算符
+	template<typename... Args>
+	void deleteObject(pointer _ptr);
+};
+
+// 获取内存大块
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::allocateBlock() noexcept
+{
+	raw_pointer rawBlock;
+	if (_spareBlock) // 备用链表里有现成的内存块, 就不用向系统申请了
+	{
+		rawBlock = reinterpret_cast<raw_pointer>(_spareBlock);
+		_spareBlock = _spareBlock->next;
+		--_spareCount;
+	}
+	else
+		rawBlock = reinterpret_cast<raw_pointer> (BlockSource::allocate(Size, NodeAlign)); // 原始态的内存大块
+	POOL_STAT(++_stats.blocks);
+	reinterpret_cast<node_pointer>(rawBlock)->next = _currentBlock; // 将原始大块转换为共用体节点的数组, 而这个数组的第一个节点被当作指针以指向下一个内存大块
+	_currentBlock = reinterpret_cast<node_pointer>(rawBlock);	// 当前内存块就是这个原始态的内存大块
+	_currentNode = _currentBlock + 1;	// 当前非指针节点就是开头指针节点的下一个
+	_lastNode = _currentNode + Num;  // 确定当前内存块的边界
+	// 这个当前内存块可能并未能被节点完全占据
+	POOL_POISON(_currentNode, Num * sizeof(node_type));	// 还没切分的节点不允许访问
+}
+
+// 获得另一个内存池的内容的所有权
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline Allocator<T, Size, Align, BlockSource>::Allocator(Allocator&& other_alloc) noexcept
+{
+	_currentBlock = other_alloc._currentBlock;
+	_currentNode = other_alloc._currentNode;
+	_lastNode = other_alloc._lastNode;
+	_freeNode = other_alloc._freeNode;
+	_spareBlock = other_alloc._spareBlock;
+	_freeCount = other_alloc._freeCount;
+	_spareCount = other_alloc._spareCount;
+	_maxSpare = other_alloc._maxSpare;
+	_highWater = other_alloc._highWater;
+	_trimAt = other_alloc._trimAt;
+	POOL_STAT(_stats = other_alloc._stats);
+	POOL_STAT(other_alloc._stats = PoolStats());
+	POOL_DEBUG(_live = std::move(other_alloc._live));
+	POOL_DEBUG(other_alloc._live.clear());
+
+	//不要忘记将源内存池的成员设为null
+	other_alloc._currentBlock = nullptr;
+	other_alloc._currentNode = nullptr;
+	other_alloc._lastNode = nullptr;
+	other_alloc._freeNode = nullptr;
+	other_alloc._spareBlock = nullptr;
+	other_alloc._freeCount = 0;
+	other_alloc._spareCount = 0;
+}
+
+// 析构函数 释放内存池所管理的内存
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline Allocator<T, Size, Align, BlockSource>::~Allocator() noexcept
+{
+	POOL_DEBUG(reportLeaks());
+
+	// 一个个内存大块节点接个释放
+	node_pointer cur = _currentBlock;
+	while (cur)
+	{
+		node_pointer tmp = cur->next;
+		POOL_UNPOISON(cur, Size);
+		BlockSource::deallocate(reinterpret_cast<void*>(cur), Size, NodeAlign);
+		cur = tmp;
+	}
+	// 备用内存块也要释放
+	cur = _spareBlock;
+	while (cur)
+	{
+		node_pointer tmp = cur->next;
+		BlockSource::deallocate(reinterpret_cast<void*>(cur), Size, NodeAlign);
+		cur = tmp;
+	}
+}
+
+
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::pointer 
+Allocator<T, Size, Align, BlockSource>::address(reference _ref) const noexcept
+{
+	return &_ref;
+}
+
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::const_pointer
+Allocator<T, Size, Align, BlockSource>::address(const_reference _ref) const noexcept
+{
+	return &_ref;
+}
+
+// 只负责分配内存, 不负责构造, 所分配的内存的内容是未定义的
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::pointer
+Allocator<T, Size, Align, BlockSource>::allocate() noexcept
+{
+	// 如果回收分块链表未空, 就取出这个链表的表头节点
+	if (_freeNode)
+	{
+		pointer result = reinterpret_cast<pointer>(_freeNode); // 注意这个操作, 使用强制转换将这个节点转化为目标类型的格式
+		_freeNode = _freeNode->next;
+		--_freeCount;
+		markReused(reinterpret_cast<node_pointer>(result));
+		POOL_DEBUG(_live[result] = 1);
+		POOL_STAT(++_stats.freeListHits);
+		POOL_STAT(recordAllocation(1));
+		return result;
+	}
+	// 否则就从内存大块申请内存
+	else
+	{
+		if (_currentNode >= _lastNode) // 如果内存池满了或者为空, 就调用addBlock()获取内存大块, 然后继续分配
+			allocateBlock();
+		POOL_STAT(++_stats.freshNodes);
+		POOL_STAT(recordAllocation(1));
+		POOL_UNPOISON(_currentNode, sizeof(node_type));
+		POOL_DEBUG(_live[_currentNode] = 1);
+		return reinterpret_cast<pointer>(_currentNode++); // 返回当前节点并向后移动一位
+	}
+}
+
+//回收内存分块
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::deallocate(pointer _ptr)
+{
+	if (_ptr)
+	{
+		POOL_DEBUG(checkLive(_ptr, 1));
+		POOL_DEBUG(_live.erase(_ptr));
+		// 使用强制转换, 将节点转化为指针, 并放到回收链表的表头
+		reinterpret_cast<node_pointer>(_ptr)->next = _freeNode; 
+		_freeNode = reinterpret_cast<node_pointer>(_ptr);
+		markFree(_freeNode);
+		POOL_STAT(recordDeallocation(1));
+		// 超过高水位就自动回收内存块
+		if (++_freeCount > _trimAt && _highWater)
+			trim();
+	}
+}
+
+// n个对象按字节数向上取整所占的节点数
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline constexpr typename Allocator<T, Size, Align, BlockSource>::size_type
+Allocator<T, Size, Align, BlockSource>::nodesFor(size_type n) noexcept
+{
+	return (n * sizeof(value_type) + sizeof(node_type) - 1) / sizeof(node_type);
+}
+
+// 节点的数据部分是next指针之后的那些字节
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::markFree(node_pointer node) noexcept
+{
+	raw_pointer tail = reinterpret_cast<raw_pointer>(node) + sizeof(node_pointer);
+	POOL_DEBUG(std::memset(tail, FreePattern, sizeof(node_type) - sizeof(node_pointer)));
+	POOL_POISON(tail, sizeof(node_type) - sizeof(node_pointer));
+	(void)tail;
+}
+
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::markReused(node_pointer node) noexcept
+{
+	POOL_UNPOISON(node, sizeof(node_type));
+#ifdef MEMORY_POOL_DEBUG
+	raw_pointer tail = reinterpret_cast<raw_pointer>(node) + sizeof(node_pointer);
+	for (size_type i = 0; i < sizeof(node_type) - sizeof(node_pointer); ++i)
+		if (static_cast<unsigned char>(tail[i]) != FreePattern)
+			poolError("freed object was written after deallocate", node);
+#endif
+	(void)node;
+}
+
+// 批量分配连续的n个对象的内存, 同样不负责构造
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::pointer
+Allocator<T, Size, Align, BlockSource>::allocate(size_type n)
+{
+	if (n == 0)
+		return nullptr;
+	if (n > max_size())
+		throw std::bad_array_new_length();
+
+	size_type count = nodesFor(n);
+
+	// 一个内存块都装不下, 就直接向系统申请
+	if (count > Num)
+	{
+		POOL_STAT(++_stats.largeAllocations);
+		pointer large = static_cast<pointer>(BlockSource::allocate(count * sizeof(node_type), NodeAlign));
+		POOL_DEBUG(_live[large] = n);
+		return large;
+	}
+
+	// 只占一个节点, 就跟单个分配一样, 优先用回收链表
+	if (count == 1)
+	{
+		pointer single = allocate();
+		POOL_DEBUG(_live[single] = n);
+		return single;
+	}
+
+	// 当前内存块剩下的不够, 把剩下的节点挂到回收链表上, 然后换一个新的内存块
+	if (static_cast<size_type>(_lastNode - _currentNode) < count)
+	{
+		// 这里直接挂到回收链表上, 不走deallocate, 以免中途触发trim
+		while (_currentNode < _lastNode)
+		{
+			POOL_UNPOISON(_currentNode, sizeof(node_type));
+			_currentNode->next = _freeNode;
+			_freeNode = _currentNode++;
+			markFree(_freeNode);
+			++_freeCount;
+		}
+		allocateBlock();
+	}
+
+	pointer result = reinterpret_cast<pointer>(_currentNode);
+	POOL_UNPOISON(_currentNode, count * sizeof(node_type));
+	POOL_DEBUG(_live[result] = n);
+	_currentNode += count;
+	POOL_STAT(++_stats.bulkAllocations);
+	POOL_STAT(_stats.freshNodes += count);
+	POOL_STAT(recordAllocation(count));
+	return result;
+}
+
+// 批量回收, n必须与分配时的n一致
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::deallocate(pointer _ptr, size_type n)
+{
+	if (!_ptr || n == 0)
+		return;
+
+	POOL_DEBUG(checkLive(_ptr, n));
+	POOL_DEBUG(_live.erase(_ptr));
+
+	size_type count = nodesFor(n);
+
+	// 当初是直接向系统申请的, 就直接还给系统
+	if (count > Num)
+	{
+		BlockSource::deallocate(reinterpret_cast<void*>(_ptr), count * sizeof(node_type), NodeAlign);
+		return;
+	}
+
+	// 把这段内存切成节点并串起来, 最后整条接到回收链表的表头
+	node_pointer first = reinterpret_cast<node_pointer>(_ptr);
+	node_pointer last = first + count - 1;
+	for (node_pointer cur = first; cur < last; ++cur)
+	{
+		cur->next = cur + 1;
+		markFree(cur);
+	}
+	last->next = _freeNode;
+	markFree(last);
+	_freeNode = first;
+	POOL_STAT(recordDeallocation(count));
+
+	_freeCount += count;
+	if (_freeCount > _trimAt && _highWater)
+		trim();
+}
+
+// 链表的归并排序, 只改next指针, 递归深度是链表长度的对数
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::node_pointer
+Allocator<T, Size, Align, BlockSource>::sortByAddress(node_pointer head) noexcept
+{
+	if (!head || !head->next)
+		return head;
+
+	// 快慢指针找到中点, 从中间断开
+	node_pointer slow = head;
+	node_pointer fast = head->next;
+	while (fast && fast->next)
+	{
+		slow = slow->next;
+		fast = fast->next->next;
+	}
+	node_pointer second = slow->next;
+	slow->next = nullptr;
+
+	node_pointer a = sortByAddress(head);
+	node_pointer b = sortByAddress(second);
+	node_pointer result = nullptr;
+	node_pointer* tail = &result;
+	while (a && b)
+	{
+		node_pointer& smaller = b < a ? b : a;
+		*tail = smaller;
+		tail = &smaller->next;
+		smaller = smaller->next;
+	}
+	*tail = a ? a : b;
+	return result;
+}
+
+// 回收完全空闲的内存块
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline typename Allocator<T, Size, Align, BlockSource>::size_type
+Allocator<T, Size, Align, BlockSource>::trim() noexcept
+{
+	if (!_currentBlock)
+		return 0;
+
+	// 把内存块按地址排好序, 当前内存块先摘出来, 排完再按地址插回去, 最后还要挪回表头
+	node_pointer current = _currentBlock;
+	node_pointer blocks = sortByAddress(current->next);
+	node_pointer* link = &blocks;
+	while (*link && *link < current)
+		link = &(*link)->next;
+	current->next = *link;
+	*link = current;
+
+	// 回收链表也按地址排好序, 每个内存块的空闲节点就是其中连续的一段
+	_freeNode = sortByAddress(_freeNode);
+	node_pointer* freeLink = &_freeNode;
+
+	size_type released = 0;
+	link = &blocks;
+	while (node_pointer block = *link)
+	{
+		// 数一数回收链表里落在这个内存块里的节点
+		node_pointer* first = freeLink;
+		node_pointer end = block + 1 + Num;
+		size_type freeInBlock = 0;
+		while (*freeLink && *freeLink < end)
+		{
+			++freeInBlock;
+			freeLink = &(*freeLink)->next;
+		}
+
+		// 已切分的节点数等于回收的节点数, 说明这个内存块里已经没有活着的对象了
+		// 当前正在切分的内存块只切到了_currentNode
+		size_type carved = block == current
+			? static_cast<size_type>(_currentNode - (current + 1))
+			: Num;
+		if (freeInBlock != carved)
+		{
+			link = &block->next;
+			continue;
+		}
+
+		// 把这个内存块的节点从回收链表里摘出来
+		*first = *freeLink;
+		freeLink = first;
+		_freeCount -= freeInBlock;
+
+		// 当前内存块不摘, 只是从头开始重新切分
+		if (block == current)
+		{
+			_currentNode = current + 1;
+			POOL_POISON(_currentNode, Num * sizeof(node_type));
+			link = &block->next;
+			continue;
+		}
+
+		*link = block->next;
+		++released;
+		POOL_UNPOISON(block, Size);
+		if (_spareCount < _maxSpare)
+		{
+			block->next = _spareBlock;
+			_spareBlock = block;
+			++_spareCount;
+		}
+		else
+			BlockSource::deallocate(reinterpret_cast<void*>(block), Size, NodeAlign);
+	}
+
+	// 当前内存块挪回表头
+	for (link = &blocks; *link != current; link = &(*link)->next)
+		;
+	*link = current->next;
+	current->next = blocks;
+
+	POOL_STAT(++_stats.trims);
+	POOL_STAT(_stats.releasedBlocks += released);
+	POOL_STAT(_stats.blocks -= released);
+
+	// 回收之后还是很长, 说明大部分节点所在的内存块里还有活着的对象, 下一次门槛翻倍
+	_trimAt = std::max(_highWater, 2 * _freeCount);
+	return released;
+}
+
+// 连备用内存块也还给系统
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::shrink_to_fit() noexcept
+{
+	trim();
+	while (_spareBlock)
+	{
+		node_pointer tmp = _spareBlock->next;
+		BlockSource::deallocate(reinterpret_cast<void*>(_spareBlock), Size, NodeAlign);
+		_spareBlock = tmp;
+	}
+	_spareCount = 0;
+}
+
+// 设置回收策略
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::setTrimPolicy(size_type highWater, size_type maxSpare) noexcept
+{
+	_highWater = highWater;
+	_trimAt = highWater;
+	_maxSpare = maxSpare;
+}
+
+//释放位于指定分块的对象所管理的资源
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::destroy(pointer _ptr)
+{
+	_ptr->~T();
+}
+
+//在指定的位置构造, 而这个位置就在用内存池分配出来的分块内存这里
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+template<typename ...Args>
+inline typename Allocator<T, Size, Align, BlockSource>::pointer
+Allocator<T, Size, Align, BlockSource>::construct(pointer _ptr, Args && ...args)
+{
+	return new(_ptr) T(std::forward<Args>(args)...); // 调用目标对象的构造函数, 参数原样转发
+}
+
+// 模拟new运算符
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+template<typename ...Args>
+inline typename Allocator<T, Size, Align, BlockSource>::pointer
+Allocator<T, Size, Align, BlockSource>::newObject(Args && ...args)
+{
+	pointer result = allocate();
+	try
+	{
+		return construct(result, std::forward<Args>(args)...);
+	}
+	catch (...)
+	{
+		// 构造失败, 把节点还给内存池, 再把异常继续抛出去
+		deallocate(result);
+		throw;
+	}
+}
+
+// 模拟delete运算符
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+template<typename ...Args>
+inline void Allocator<T, Size, Align, BlockSource>::deleteObject(pointer _ptr)
+{
+	if (_ptr)
+	{
+		POOL_DEBUG(checkLive(_ptr, 1));	// 在调用析构函数之前就要检查, 否则重复释放会先把析构函数再跑一遍
+		destroy(_ptr);
+		deallocate(_ptr);
+	}
+}
+
+
+/*
+*	符合标准库分配器要求的适配器
+*	
+*	标准容器会把分配器rebind到自己真正要分配的类型上, 比如std::list<int>实际分配的是链表节点,
+*	所以这里不能只持有一个Allocator<T, Size>, 而是每个类型都有一个自己的内存池, 放在函数内的静态变量里.
+*	这样PoolAllocator本身是无状态的, 所有实例都相等, 可以随意复制.
+*	
+*	std::list, std::map这种基于节点的容器每次只分配一个节点, 正好落在内存池的快速路径上;
+*	std::vector一次分配一整段, 就走allocate(n)的批量路径.
+*	
+*	注意这个内存池跟原来的Allocator一样没有同步, 只能在单个线程里用.
+*	而且内存池是静态变量, 所以使用它的容器不能是比它更晚析构的静态对象.
+*/
+template <typename T, size_t Size = 1024>
+class PoolAllocator
+{
+public:
+	using value_type = T;
+	using size_type = size_t;
+	using difference_type = ptrdiff_t;
+	using is_always_equal = std::true_type;
+
+	template <typename U>
+	struct rebind
+	{
+		using other = PoolAllocator<U, Size>;
+	};
+
+	PoolAllocator() noexcept = default;
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U, Size>&) noexcept {}
+
+	// n超过max_size()时由内存池抛出std::bad_array_new_length
+	T* allocate(size_type n) { return pool().allocate(n); }
+	void deallocate(T* _ptr, size_type n) { pool().deallocate(_ptr, n); }
+
+	size_type max_size() const noexcept { return Allocator<T, Size>::max_size(); }
+
+	// 每个类型一个内存池
+	static Allocator<T, Size>& pool()
+	{
+		static Allocator<T, Size> _pool;
+		return _pool;
+	}
+};
+
+template <typename T, typename U, size_t Size>
+inline bool operator==(const PoolAllocator<T, Size>&, const PoolAllocator<U, Size>&) noexcept
+{
+	return true;
+}
+
+template <typename T, typename U, size_t Size>
+inline bool operator!=(const PoolAllocator<T, Size>&, const PoolAllocator<U, Size>&) noexcept
+{
+	return false;
+}
+
+
+#ifdef MEMORY_POOL_STATS
+// 分配时更新活着的节点数和当前突发的长度
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::recordAllocation(size_type count) noexcept
+{
+	++_stats.allocations;
+	_stats.liveNodes += count;
+	_stats.peakLiveNodes = std::max(_stats.peakLiveNodes, _stats.liveNodes);
+	_stats.currentBurst += count;
+}
+
+// 回收时结束当前的突发, 把它的长度记到直方图里
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::recordDeallocation(size_type count) noexcept
+{
+	++_stats.deallocations;
+	_stats.liveNodes -= count;
+	if (_stats.currentBurst)
+	{
+		size_type bucket = 0;
+		while ((_stats.currentBurst >> (bucket + 1)) && bucket + 1 < BurstBuckets)
+			++bucket;
+		++_stats.burstHistogram[bucket];
+		_stats.currentBurst = 0;
+	}
+}
+
+// 输出统计数据
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::dumpStats(std::ostream& os) const
+{
+	size_type carved = _stats.freeListHits + _stats.freshNodes;
+	os << "Allocator<" << sizeof(value_type) << " bytes, " << Size << "> stats" << '\n';
+	os << "  nodes per block: " << Num << '\n';
+	os << "  blocks: " << _stats.blocks << " (spare " << _spareCount << ")" << '\n';
+	os << "  free nodes: " << _freeCount << '\n';
+	os << "  live nodes: " << _stats.liveNodes << " (peak " << _stats.peakLiveNodes << ")" << '\n';
+	os << "  allocations: " << _stats.allocations << ", deallocations: " << _stats.deallocations << '\n';
+	os << "  bulk: " << _stats.bulkAllocations << ", large: " << _stats.largeAllocations << '\n';
+	os << "  free list hit rate: " << (carved ? 100.0 * _stats.freeListHits / carved : 0.0) << "%" << '\n';
+	os << "  trims: " << _stats.trims << ", released blocks: " << _stats.releasedBlocks << '\n';
+	os << "  burst histogram:" << '\n';
+	for (size_type i = 0; i < BurstBuckets; ++i)
+		if (_stats.burstHistogram[i])
+			os << "    [" << (size_type(1) << i) << ", " << (size_type(1) << (i + 1)) << "): " << _stats.burstHistogram[i] << '\n';
+}
+#endif
+
+#ifdef MEMORY_POOL_DEBUG
+// 检查要释放的指针
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::checkLive(const void* _ptr, size_type n) const noexcept
+{
+	auto it = _live.find(_ptr);
+	if (it == _live.end())
+	{
+		if (owns(_ptr))
+			poolError("double free, or pointer was never allocated", _ptr);
+		poolError("pointer does not belong to this pool", _ptr);
+	}
+	if (it->second != n)
+		poolError("deallocate size does not match allocate size", _ptr);
+}
+
+// 指针是否正好落在本内存池某个内存块的节点上
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline bool Allocator<T, Size, Align, BlockSource>::owns(const void* _ptr) const noexcept
+{
+	const char* p = static_cast<const char*>(_ptr);
+	for (node_pointer block = _currentBlock; block; block = block->next)
+	{
+		const char* first = reinterpret_cast<const char*>(block + 1);
+		const char* last = reinterpret_cast<const char*>(block + 1 + Num);
+		if (p >= first && p < last)
+			return (p - first) % sizeof(node_type) == 0;
+	}
+	return false;
+}
+
+// 析构时还活着的对象就是泄漏了
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::reportLeaks() const noexcept
+{
+	if (_live.empty())
+		return;
+
+	std::fprintf(stderr, "Allocator: %zu allocation(s) of %zu-byte objects leaked\n", _live.size(), sizeof(value_type));
+	size_type shown = 0;
+	for (const auto& leak : _live)
+	{
+		if (shown++ == 8)
+		{
+			std::fprintf(stderr, "  ...\n");
+			break;
+		}
+		std::fprintf(stderr, "  %p (%zu object(s))\n", leak.first, leak.second);
+	}
+}
+
+template<typename T, size_t Size, size_t Align, typename BlockSource>
+inline void Allocator<T, Size, Align, BlockSource>::poolError(const char* message, const void* _ptr) noexcept
+{
+	std::fprintf(stderr, "Allocator: %s: %p\n", message, _ptr);
+	std::abort();
+}
+#endif
+
+// 把对象还给所属内存池的删除器
+template <typename T, size_t Size = 1024, size_t Align = alignof(T), typename BlockSource = NewBlockSource>
+class PoolDeleter
+{
+	Allocator<T, Size, Align, BlockSource>* _pool = nullptr;
+public:
+	PoolDeleter() noexcept = default;
+	explicit PoolDeleter(Allocator<T, Size, Align, BlockSource>& pool) noexcept : _pool(&pool) {}
+
+	void operator()(T* _ptr) const
+	{
+		_pool->deleteObject(_ptr);
+	}
+};
+
+// 对象放在内存池里的unique_ptr
+template <typename T, size_t Size = 1024, size_t Align = alignof(T), typename BlockSource = NewBlockSource>
+using pool_unique_ptr = std::unique_ptr<T, PoolDeleter<T, Size, Align, BlockSource>>;
+
+// 在内存池里构造对象并交给pool_unique_ptr管理
+template <typename T, size_t Size, size_t Align, typename BlockSource, typename... Args>
+inline pool_unique_ptr<T, Size, Align, BlockSource> makePoolUnique(Allocator<T, Size, Align, BlockSource>& pool, Args && ...args)
+{
+	using deleter_type = PoolDeleter<T, Size, Align, BlockSource>;
+	return pool_unique_ptr<T, Size, Align, BlockSource>(pool.newObject(std::forward<Args>(args)...), deleter_type(pool));
+}
+
+#undef POOL_STAT
+#undef POOL_DEBUG
+#undef POOL_POISON
+#undef POOL_UNPOISON
+
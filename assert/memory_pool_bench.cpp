@@ -0,0 +1,264 @@
+/*
+*	内存池的性能测试
+*	
+*	memory_pool.hpp里说内存池可以避免内存碎片, 大大提高内存分配效率, 这里就来实际测一测.
+*	参加比较的有:
+*		pool<Size>		memory_pool.hpp里的Allocator<T, Size>::newObject/deleteObject, 分别测试几种不同的内存块大小
+*		new/delete		原生的new和delete运算符
+*		std::allocator	标准库的分配器, allocate之后再定点构造
+*		pmr::pool		std::pmr::unsynchronized_pool_resource, 标准库自带的单线程内存池
+*	
+*	对象的大小取16, 64, 256字节三种, 释放的顺序有三种:
+*		LIFO	后分配的先释放, 就像栈一样, 对内存池最友好
+*		FIFO	先分配的先释放, 就像队列一样
+*		random	打乱顺序释放, 最接近真实的使用情况, 也最容易造成碎片
+*	
+*	每一项测试都是先连续创建Count个对象, 然后按指定顺序全部释放, 重复Rounds轮, 输出:
+*		ns/op		平均每次创建或释放所用的纳秒数
+*		RSS			测试结束时(分配器还没析构)常驻内存比测试开始前多了多少(KB)
+*		misses		测试期间的缓存未命中次数, 用Linux的perf_event_open读硬件计数器, 没有权限时显示n/a
+*	
+*	在Linux上每一项测试都在一个新fork出来的子进程里跑.
+*	释放的内存分配器往往留着不还给系统, 如果都在一个进程里跑, 前面的测试留下的内存会一直算在后面的测试头上,
+*	而且后面的测试可以直接用前面留下的内存, 常驻内存就不会再涨了, 这样RSS一列就没法比较了.
+*	
+*	在assert目录下编译:
+*		g++ -std=c++17 -O2 -DNDEBUG memory_pool_bench.cpp -o memory_pool_bench
+*	测试的写法参考了Google Benchmark, 但是为了不引入额外的依赖, 计时和统计都是自己写的.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "memory_pool.hpp"
+
+constexpr size_t Count = 100000;	// 每一轮创建的对象个数
+constexpr size_t Rounds = 20;		// 轮数
+
+// 测试用的对象, Bytes个字节, 构造时写一下内存, 免得被优化掉
+template <size_t Bytes>
+struct Object
+{
+	char data[Bytes];
+	explicit Object(char c) { data[0] = c; data[Bytes - 1] = c; }
+};
+
+enum class Order { LIFO, FIFO, Random };
+
+const char* orderName(Order order)
+{
+	switch (order)
+	{
+	case Order::LIFO: return "LIFO";
+	case Order::FIFO: return "FIFO";
+	default: return "random";
+	}
+}
+
+// 当前进程的常驻内存, 单位KB
+long residentKB()
+{
+#ifdef __linux__
+	long pages = 0, resident = 0;
+	FILE* file = std::fopen("/proc/self/statm", "r");
+	if (file)
+	{
+		if (std::fscanf(file, "%ld %ld", &pages, &resident) != 2)
+			resident = 0;
+		std::fclose(file);
+	}
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+	return 0;
+#endif
+}
+
+// 硬件缓存未命中计数器
+class CacheMissCounter
+{
+	int _fd = -1;
+public:
+	CacheMissCounter()
+	{
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~CacheMissCounter()
+	{
+#ifdef __linux__
+		if (_fd >= 0)
+			close(_fd);
+#endif
+	}
+
+	bool available() const { return _fd >= 0; }
+
+	void start()
+	{
+#ifdef __linux__
+		if (_fd >= 0)
+		{
+			ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	long long stop()
+	{
+		long long count = 0;
+#ifdef __linux__
+		if (_fd >= 0)
+		{
+			ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(_fd, &count, sizeof(count)) != sizeof(count))
+				count = 0;
+		}
+#endif
+		return count;
+	}
+};
+
+// 下面是参加比较的几种分配方式, 都提供create和destroy两个函数
+
+template <typename T, size_t Size>
+struct PoolStrategy
+{
+	Allocator<T, Size> pool;
+	T* create(char c) { return pool.newObject(c); }
+	void destroy(T* p) { pool.deleteObject(p); }
+};
+
+template <typename T>
+struct NewDeleteStrategy
+{
+	T* create(char c) { return new T(c); }
+	void destroy(T* p) { delete p; }
+};
+
+template <typename T>
+struct StdAllocatorStrategy
+{
+	std::allocator<T> alloc;
+	T* create(char c) { T* p = alloc.allocate(1); return new(p) T(c); }
+	void destroy(T* p) { p->~T(); alloc.deallocate(p, 1); }
+};
+
+template <typename T>
+struct PmrPoolStrategy
+{
+	std::pmr::unsynchronized_pool_resource resource;
+	T* create(char c) { return new(resource.allocate(sizeof(T), alignof(T))) T(c); }
+	void destroy(T* p) { p->~T(); resource.deallocate(p, sizeof(T), alignof(T)); }
+};
+
+// 跑一项测试并输出一行结果
+template <typename T, typename Strategy>
+void run(const char* name, Order order)
+{
+	long baseKB = residentKB();
+	auto strategy = std::make_unique<Strategy>();
+	std::vector<T*> objects(Count);
+	std::vector<size_t> indices(Count);
+	for (size_t i = 0; i < Count; ++i)
+		indices[i] = i;
+	if (order == Order::LIFO)
+		std::reverse(indices.begin(), indices.end());
+	else if (order == Order::Random)
+		std::shuffle(indices.begin(), indices.end(), std::mt19937(42));
+
+	CacheMissCounter misses;
+	misses.start();
+	auto begin = std::chrono::steady_clock::now();
+	for (size_t round = 0; round < Rounds; ++round)
+	{
+		for (size_t i = 0; i < Count; ++i)
+			objects[i] = strategy->create(static_cast<char>(i));
+		for (size_t i = 0; i < Count; ++i)
+			strategy->destroy(objects[indices[i]]);
+	}
+	auto end = std::chrono::steady_clock::now();
+	long long missCount = misses.stop();
+
+	double ns = std::chrono::duration<double, std::nano>(end - begin).count() / (2.0 * Count * Rounds);
+	std::printf("%-14s %4zu B  %-7s %8.2f ns/op  %8ld KB  ", name, sizeof(T), orderName(order), ns, residentKB() - baseKB);
+	if (misses.available())
+		std::printf("%12lld misses\n", missCount);
+	else
+		std::printf("%12s misses\n", "n/a");
+}
+
+// 在子进程里跑一项测试, 让每一项测试的常驻内存都从同一个起点开始算
+template <typename T, typename Strategy>
+void runIsolated(const char* name, Order order)
+{
+#ifdef __linux__
+	std::fflush(stdout);	// 不然缓冲区里还没输出的内容会被子进程再输出一遍
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		run<T, Strategy>(name, order);
+		std::fflush(stdout);
+		_exit(0);
+	}
+	if (pid > 0)
+	{
+		waitpid(pid, nullptr, 0);
+		return;
+	}
+#endif
+	// 不是Linux或者fork失败了, 就只能在本进程里跑
+	run<T, Strategy>(name, order);
+}
+
+// 一种对象大小的所有测试
+template <size_t Bytes>
+void runAll()
+{
+	using T = Object<Bytes>;
+	for (Order order : { Order::LIFO, Order::FIFO, Order::Random })
+	{
+		runIsolated<T, PoolStrategy<T, 4 * sizeof(T)>>("pool<4x>", order);
+		runIsolated<T, PoolStrategy<T, 4096>>("pool<4096>", order);
+		runIsolated<T, PoolStrategy<T, 65536>>("pool<65536>", order);
+		runIsolated<T, NewDeleteStrategy<T>>("new/delete", order);
+		runIsolated<T, StdAllocatorStrategy<T>>("std::allocator", order);
+		runIsolated<T, PmrPoolStrategy<T>>("pmr::pool", order);
+	}
+	std::printf("\n");
+}
+
+int main()
+{
+	std::printf("%zu objects x %zu rounds\n\n", Count, Rounds);
+	runAll<16>();
+	runAll<64>();
+	runAll<256>();
+	return 0;
+}
+
@@ -0,0 +1,41 @@
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "class.hpp"
+
+int main()
+{
+    Circle c("blue", 2, 1, -1);
+
+    cout << "text form:" << endl;
+    c.show();
+    cout << "json form:" << endl;
+    c.show_json();
+
+    // any ostream can be the target, here a string
+    std::ostringstream text;
+    c.show_json(text);
+    cout << "json in a string: " << text.str();
+
+    std::ostringstream bytes;
+    c.show_binary(bytes);
+    cout << "binary form: " << bytes.str().size() << " bytes" << endl;
+
+    // destroy a lot of circles: their messages are passed on in 64 KB batches
+    // instead of one flush each, and go to a file so the terminal stays readable
+    std::ofstream file("output_sink.log");
+    log_sink().redirect(file);
+    auto begin = std::chrono::steady_clock::now();
+    {
+        std::vector<Circle> circles(1000000);
+    }
+    log_sink().flush();
+    auto end = std::chrono::steady_clock::now();
+    log_sink().redirect(cout);
+    cout << "destroyed 1000000 circles in "
+         << std::chrono::duration<double, std::milli>(end - begin).count() << " ms" << endl;
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#ifndef OUTPUT_SINK_H_
+#define OUTPUT_SINK_H_
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <vector>
+
+// Stream buffer that collects output in a fixed, reused array and hands it
+// to the target stream buffer only when the array is full or on flush.
+// It never flushes the target itself, so no syscall happens per message.
+// Several threads may write at once, like with cout: every write takes a
+// mutex, so characters from different threads may interleave but nothing
+// races. For that the streambuf put area is left empty, which sends even
+// single characters through overflow() and its lock.
+class SinkBuffer : public std::streambuf
+{
+private:
+    std::vector<char> buffer_;
+    size_t used_ = 0;
+    std::streambuf *target_;
+    bool direct_ = false; // pass everything straight on, no buffering
+    mutable std::mutex mutex_;
+
+    // callers hold mutex_
+    int drain()
+    {
+        std::streamsize n = static_cast<std::streamsize>(used_);
+        used_ = 0;
+        if (n > 0 && target_ && target_->sputn(buffer_.data(), n) != n)
+            return -1;
+        return 0;
+    }
+
+    std::streamsize put(const char *s, std::streamsize n)
+    {
+        if (direct_ || static_cast<size_t>(n) > buffer_.size())
+        {
+            if (drain() == -1)
+                return 0;
+            return target_ ? target_->sputn(s, n) : n;
+        }
+        if (used_ + n > buffer_.size() && drain() == -1)
+            return 0;
+        std::copy(s, s + n, buffer_.data() + used_);
+        used_ += n;
+        return n;
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (traits_type::eq_int_type(ch, traits_type::eof()))
+            return drain() == -1 ? traits_type::eof() : traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        return put(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return put(s, n);
+    }
+
+    int sync() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return drain();
+    }
+
+public:
+    SinkBuffer(std::streambuf *target, size_t capacity) : buffer_(capacity), target_(target) {}
+
+    void set_target(std::streambuf *target)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain();
+        target_ = target;
+    }
+
+    // pass on what is buffered and stop buffering from now on
+    void set_direct()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain();
+        direct_ = true;
+    }
+
+    size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return used_;
+    }
+};
+
+// An ostream writing through a SinkBuffer.
+// Anything that prints to an ostream can print here, and the text is only
+// passed on in batches of capacity bytes or when flushed. Redirect it to
+// another stream, e.g. a file or an ostringstream, to plug in another target.
+class BufferedSink : public std::ostream
+{
+private:
+    SinkBuffer buf_;
+
+public:
+    explicit BufferedSink(std::ostream &target = std::cout, size_t capacity = 1 << 16)
+        : std::ostream(nullptr), buf_(target.rdbuf(), capacity)
+    {
+        rdbuf(&buf_);
+    }
+    ~BufferedSink() { flush(); }
+
+    void redirect(std::ostream &target) { buf_.set_target(target.rdbuf()); }
+    void redirect(std::streambuf *target) { buf_.set_target(target); } // nullptr drops everything
+    size_t pending() const { return buf_.pending(); }
+    // pass on what is pending and write through unbuffered from now on
+    void unbuffer() { buf_.set_direct(); }
+};
+
+// The sink Circle logs to by default.
+// cout is tied to it, so whatever was logged is passed on before the next
+// thing printed with cout and the two never come out of order.
+inline BufferedSink &log_sink()
+{
+    // never destroyed, so objects destroyed during exit can still log
+    static BufferedSink *sink = []
+    {
+        BufferedSink *s = new BufferedSink(std::cout);
+        std::cout.tie(s);
+        return s;
+    }();
+    return *sink;
+}
+
+namespace output_sink_detail
+{
+// The way <iostream> keeps cout alive for static objects: every file that
+// includes this header gets one Init, created before that file's own static
+// objects and so destroyed after them. When the last Init goes, every static
+// Circle that was going to log has logged; pass the rest on and write
+// through unbuffered from then on, for anything destroyed even later.
+class Init
+{
+private:
+    static int &count()
+    {
+        static int n = 0;
+        return n;
+    }
+
+public:
+    Init()
+    {
+        if (count()++ == 0)
+            log_sink();
+    }
+    ~Init()
+    {
+        if (--count() == 0)
+        {
+            log_sink().unbuffer();
+        }
+    }
+};
+
+static Init init;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "small_string.hpp"
+
+using ::std::cout;
+using ::std::endl;
+
+int main()
+{
+    SmallString s1; // empty, nothing allocated
+    SmallString s2("Rust");
+    SmallString s3("a string too long to fit inside the object");
+
+    cout << "s1: \"" << s1 << "\", capacity " << s1.capacity() << endl;
+    cout << "s2: " << s2 << ", capacity " << s2.capacity() << endl;
+    cout << "s3: " << s3 << ", capacity " << s3.capacity() << endl;
+
+    cout << "assign s2 to s1" << endl;
+    s1 = s2;
+    cout << "s1: " << s1 << endl;
+
+    cout << "assign a short string to s3, its buffer is reused" << endl;
+    const char *before = s3.c_str();
+    s3 = "Csharp";
+    cout << "s3: " << s3 << ", same buffer: " << (s3.c_str() == before) << endl;
+
+    cout << "move s3 into s4, the buffer moves with it" << endl;
+    SmallString s4 = std::move(s3);
+    cout << "s4: " << s4 << ", same buffer: " << (s4.c_str() == before) << ", s3 is now \"" << s3 << "\"" << endl;
+
+    s4 += ", Cpp";
+    s4 += s4;
+    cout << "s4 appended to itself: " << s4 << ", length " << s4.length() << endl;
+
+    std::vector<SmallString> names{"Go", "Cpp", "Rust"};
+    names.push_back(std::move(s2)); // no copy while the vector grows either
+    cout << "names:";
+    for (const SmallString &name : names)
+        cout << " " << name;
+    cout << endl;
+
+    return 0;
+}
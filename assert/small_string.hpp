@@ -0,0 +1,229 @@
+#ifndef SMALL_STRING_H_
+#define SMALL_STRING_H_
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string_view>
+#include <utility>
+
+// The string StringBad in dynamic_class.cpp wanted to be.
+//   - strings of up to 15 characters live inside the object, no heap at all
+//   - the length is kept, nothing calls strlen after construction
+//   - copy assignment reuses the buffer when it is big enough
+//   - moving steals the heap buffer instead of copying it
+// data_ always points at the characters, either local_ or the heap, so
+// reading never has to check which one is in use.
+class SmallString
+{
+private:
+    static constexpr size_t local_capacity = 15;
+
+    char *data_;
+    size_t len_;
+    union
+    {
+        size_t capacity_; // when on the heap, not counting the '\0'
+        char local_[local_capacity + 1];
+    };
+
+    bool is_local() const { return data_ == local_; }
+
+    // room for at least n characters, the content is lost
+    void make_room(size_t n);
+    void assign(const char *s, size_t n);
+
+public:
+    SmallString() : data_(local_), len_(0) { local_[0] = '\0'; }
+    SmallString(const char *s) : SmallString(s, std::strlen(s)) {}
+    SmallString(const char *s, size_t n);
+    explicit SmallString(std::string_view s) : SmallString(s.data(), s.size()) {}
+    SmallString(const SmallString &s) : SmallString(s.data_, s.len_) {}
+    SmallString(SmallString &&s) noexcept;
+    ~SmallString()
+    {
+        if (!is_local())
+            delete[] data_;
+    }
+
+    SmallString &operator=(const SmallString &s);
+    SmallString &operator=(SmallString &&s) noexcept;
+    SmallString &operator=(const char *s);
+
+    size_t size() const { return len_; }
+    size_t length() const { return len_; }
+    size_t capacity() const { return is_local() ? local_capacity : capacity_; }
+    bool empty() const { return len_ == 0; }
+    const char *c_str() const { return data_; }
+    const char *data() const { return data_; }
+    char &operator[](size_t i) { return data_[i]; }
+    const char &operator[](size_t i) const { return data_[i]; }
+    operator std::string_view() const { return std::string_view(data_, len_); }
+
+    void reserve(size_t n);
+    void clear();
+    SmallString &append(const char *s, size_t n);
+    SmallString &operator+=(const SmallString &s) { return append(s.data_, s.len_); }
+    SmallString &operator+=(const char *s) { return append(s, std::strlen(s)); }
+    void swap(SmallString &s) noexcept;
+
+    friend bool operator==(const SmallString &a, const SmallString &b)
+    {
+        return a.len_ == b.len_ && std::memcmp(a.data_, b.data_, a.len_) == 0;
+    }
+    friend bool operator!=(const SmallString &a, const SmallString &b) { return !(a == b); }
+    friend bool operator<(const SmallString &a, const SmallString &b)
+    {
+        return std::string_view(a) < std::string_view(b);
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const SmallString &s)
+    {
+        return os.write(s.data_, s.len_);
+    }
+};
+
+inline void SmallString::make_room(size_t n)
+{
+    if (n <= capacity())
+        return;
+    char *buffer = new char[n + 1];
+    if (!is_local())
+        delete[] data_;
+    data_ = buffer;
+    capacity_ = n;
+}
+
+inline void SmallString::assign(const char *s, size_t n)
+{
+    make_room(n);
+    std::memmove(data_, s, n); // memmove, s may point into this string
+    data_[n] = '\0';
+    len_ = n;
+}
+
+inline SmallString::SmallString(const char *s, size_t n) : data_(local_), len_(n)
+{
+    if (n > local_capacity)
+    {
+        data_ = new char[n + 1];
+        capacity_ = n;
+    }
+    std::memcpy(data_, s, n);
+    data_[n] = '\0';
+}
+
+inline SmallString::SmallString(SmallString &&s) noexcept : len_(s.len_)
+{
+    if (s.is_local())
+    {
+        data_ = local_;
+        std::memcpy(local_, s.local_, sizeof(local_)); // a fixed size compiles to two moves, no call
+    }
+    else
+    {
+        data_ = s.data_;
+        capacity_ = s.capacity_;
+        s.data_ = s.local_;
+    }
+    s.len_ = 0;
+    s.local_[0] = '\0';
+}
+
+inline SmallString &SmallString::operator=(const SmallString &s)
+{
+    if (this != &s)
+        assign(s.data_, s.len_); // keeps our buffer if s fits in it
+    return *this;
+}
+
+inline SmallString &SmallString::operator=(SmallString &&s) noexcept
+{
+    if (this == &s)
+        return *this;
+    if (s.is_local())
+    {
+        // nothing to steal, copy the 16 bytes; our own buffer is at least that big
+        std::memcpy(data_, s.local_, sizeof(local_));
+        len_ = s.len_;
+    }
+    else
+    {
+        if (!is_local())
+            delete[] data_;
+        data_ = s.data_;
+        capacity_ = s.capacity_;
+        len_ = s.len_;
+        s.data_ = s.local_;
+    }
+    s.len_ = 0;
+    s.local_[0] = '\0';
+    return *this;
+}
+
+inline SmallString &SmallString::operator=(const char *s)
+{
+    assign(s, std::strlen(s));
+    return *this;
+}
+
+inline void SmallString::reserve(size_t n)
+{
+    if (n <= capacity())
+        return;
+    char *buffer = new char[n + 1];
+    std::memcpy(buffer, data_, len_ + 1);
+    if (!is_local())
+        delete[] data_;
+    data_ = buffer;
+    capacity_ = n;
+}
+
+inline void SmallString::clear()
+{
+    len_ = 0;
+    data_[0] = '\0';
+}
+
+inline SmallString &SmallString::append(const char *s, size_t n)
+{
+    if (len_ + n > capacity())
+    {
+        // s may point into this string, copy it before the old buffer goes
+        size_t grown = std::max(len_ + n, 2 * capacity());
+        char *buffer = new char[grown + 1];
+        std::memcpy(buffer, data_, len_);
+        std::memcpy(buffer + len_, s, n);
+        if (!is_local())
+            delete[] data_;
+        data_ = buffer;
+        capacity_ = grown;
+    }
+    else
+        std::memmove(data_ + len_, s, n);
+    len_ += n;
+    data_[len_] = '\0';
+    return *this;
+}
+
+inline void SmallString::swap(SmallString &s) noexcept
+{
+    SmallString tmp(std::move(s));
+    s = std::move(*this);
+    *this = std::move(tmp);
+}
+
+namespace std
+{
+template <>
+struct hash<SmallString>
+{
+    size_t operator()(const SmallString &s) const noexcept
+    {
+        return hash<string_view>()(string_view(s));
+    }
+};
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "small_string.hpp"
+
+using ::std::cout;
+using ::std::endl;
+
+// keys like "user:1234" or "order-item:98765", mostly under 16 characters
+std::vector<std::string> make_keys(size_t count)
+{
+    const char *prefixes[] = {"id:", "user:", "order:", "session-key:", "order-item:"};
+    std::mt19937 gen(11);
+    std::vector<std::string> keys;
+    char buffer[64];
+    for (size_t i = 0; i < count; i++)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%s%u", prefixes[gen() % 5], unsigned(gen() % 1000000));
+        keys.push_back(buffer);
+    }
+    return keys;
+}
+
+template <class Body>
+void bench(const char *name, Body body)
+{
+    auto begin = std::chrono::steady_clock::now();
+    size_t check = body();
+    auto end = std::chrono::steady_clock::now();
+    cout << "  " << name << ": " << std::chrono::duration<double, std::milli>(end - begin).count()
+         << " ms (" << check << ")" << endl;
+}
+
+template <class S>
+void run(const char *type, const std::vector<std::string> &keys)
+{
+    cout << type << endl;
+    std::vector<S> strings;
+    strings.reserve(keys.size()); // time the strings, not the vector growing
+    bench("construct from char *", [&] {
+        for (const std::string &key : keys)
+            strings.push_back(S(key.c_str()));
+        return strings.size();
+    });
+    std::vector<S> copies;
+    bench("copy", [&] {
+        copies = strings;
+        return copies.size();
+    });
+    bench("assign over existing strings", [&] {
+        for (size_t i = 0; i < copies.size(); i++)
+            copies[i] = strings[copies.size() - 1 - i];
+        return copies.size();
+    });
+    bench("sort (moves)", [&] {
+        std::sort(copies.begin(), copies.end());
+        return copies.size();
+    });
+    std::unordered_map<S, int> map;
+    bench("hash map insert + lookup", [&] {
+        for (size_t i = 0; i < strings.size(); i++)
+            map[strings[i]] = int(i);
+        size_t found = 0;
+        for (const S &s : copies)
+            found += map.count(s);
+        return found;
+    });
+}
+
+int main()
+{
+    std::vector<std::string> keys = make_keys(1000000);
+    size_t short_keys = std::count_if(keys.begin(), keys.end(), [](const std::string &k) { return k.size() <= 15; });
+    cout << keys.size() << " keys, " << short_keys << " of them up to 15 characters" << endl;
+    // twice each, the first round also pays for the heap growing
+    for (int round = 0; round < 2; round++)
+    {
+        run<std::string>("std::string", keys);
+        run<SmallString>("SmallString", keys);
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+#ifndef VECTOR_H_
+#define VECTOR_H_
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <type_traits>
+
+// 2-D vector from use_class.cpp as a constexpr value type.
+// a + b and k * a don't compute anything, they return small expression
+// objects that remember the operands; the result is only computed when the
+// expression is turned into a Vector, one component at a time. So
+// Vector r = a + b * 2.0 + c; reads each operand once and makes no
+// temporaries. a * b is still the 2-D cross product and returns a double.
+// Don't keep an expression in an auto variable: it refers to its operands,
+// which may be temporaries that are gone by the time it is used.
+
+// sqrt that can run at compile time.
+// Newton's method started above the root only goes down, so stop as soon as
+// a step doesn't make it smaller.
+constexpr double const_sqrt(double v)
+{
+    if (!(v >= 0)) // negative or NaN
+        return std::numeric_limits<double>::quiet_NaN();
+    if (v == 0 || v == std::numeric_limits<double>::infinity())
+        return v;
+    double x = v < 1 ? 1 : v;
+    for (;;)
+    {
+        double next = 0.5 * (x + v / x);
+        if (next >= x)
+            return x;
+        x = next;
+    }
+}
+
+// std::sqrt at run time, const_sqrt during constant evaluation
+#if defined(__cpp_lib_is_constant_evaluated)
+#define VECTOR_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__GNUC__) && __GNUC__ >= 9
+#define VECTOR_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define VECTOR_CONSTANT_EVALUATED() true
+#endif
+
+constexpr double vector_sqrt(double v)
+{
+    if (VECTOR_CONSTANT_EVALUATED())
+        return const_sqrt(v);
+    return std::sqrt(v);
+}
+
+#undef VECTOR_CONSTANT_EVALUATED
+
+class Vector;
+
+// base of every vector expression, E is the expression type itself
+template <typename E>
+struct VecExpr
+{
+    constexpr const E &self() const { return static_cast<const E &>(*this); }
+    constexpr double x() const { return self().x(); }
+    constexpr double y() const { return self().y(); }
+
+    constexpr double norm() const { return vector_sqrt(x() * x() + y() * y()); }
+};
+
+// operands that are Vectors are kept by reference, sub-expressions by value
+template <typename E>
+using vec_operand = typename std::conditional<std::is_same<E, Vector>::value, const Vector &, const E>::type;
+
+template <typename L, typename R>
+struct VecSum : VecExpr<VecSum<L, R>>
+{
+    vec_operand<L> l;
+    vec_operand<R> r;
+    constexpr VecSum(const L &lhs, const R &rhs) : l(lhs), r(rhs) {}
+    constexpr double x() const { return l.x() + r.x(); }
+    constexpr double y() const { return l.y() + r.y(); }
+};
+
+template <typename E>
+struct VecScale : VecExpr<VecScale<E>>
+{
+    vec_operand<E> e;
+    double lambda;
+    constexpr VecScale(const E &expr, double k) : e(expr), lambda(k) {}
+    constexpr double x() const { return e.x() * lambda; }
+    constexpr double y() const { return e.y() * lambda; }
+};
+
+class Vector : public VecExpr<Vector>
+{
+    double x_index;
+    double y_index;
+
+public:
+    constexpr explicit Vector(double x = 0, double y = 0) : x_index(x), y_index(y) {}
+    constexpr Vector(int d) : x_index(d), y_index(0) {}
+    // evaluates the whole expression in one pass
+    template <typename E>
+    constexpr Vector(const VecExpr<E> &expr) : x_index(expr.x()), y_index(expr.y()) {}
+
+    constexpr double x() const { return x_index; }
+    constexpr double y() const { return y_index; }
+
+    template <typename E>
+    constexpr Vector &operator+=(const VecExpr<E> &expr)
+    {
+        double x = expr.x(), y = expr.y(); // expr may refer to *this
+        x_index += x;
+        y_index += y;
+        return *this;
+    }
+    constexpr Vector &operator*=(double lambda)
+    {
+        x_index *= lambda;
+        y_index *= lambda;
+        return *this;
+    }
+
+    void show() const
+    {
+        std::cout << "x_index is: " << x_index << '\n';
+        std::cout << "y_index is: " << y_index << '\n';
+        std::cout << '\n';
+    }
+
+    // the norm; explicit, so a Vector never turns into a number by accident, e.g. in a + 1
+    constexpr explicit operator double() const { return norm(); }
+};
+
+template <typename L, typename R>
+constexpr VecSum<L, R> operator+(const VecExpr<L> &lhs, const VecExpr<R> &rhs)
+{
+    return VecSum<L, R>(lhs.self(), rhs.self());
+}
+
+template <typename E>
+constexpr VecScale<E> operator*(const VecExpr<E> &expr, double lambda)
+{
+    return VecScale<E>(expr.self(), lambda);
+}
+
+template <typename E>
+constexpr VecScale<E> operator*(double lambda, const VecExpr<E> &expr)
+{
+    return VecScale<E>(expr.self(), lambda);
+}
+
+// 2-D cross product
+template <typename L, typename R>
+constexpr double operator*(const VecExpr<L> &lhs, const VecExpr<R> &rhs)
+{
+    return lhs.x() * rhs.y() - lhs.y() * rhs.x();
+}
+
+template <typename L, typename R>
+constexpr bool operator==(const VecExpr<L> &lhs, const VecExpr<R> &rhs)
+{
+    return lhs.x() == rhs.x() && lhs.y() == rhs.y();
+}
+
+template <typename E>
+std::ostream &operator<<(std::ostream &os, const VecExpr<E> &vec)
+{
+    os << "x_index is: " << vec.x() << '\n';
+    os << "y_index is: " << vec.y() << '\n';
+    return os;
+}
+
+#endif
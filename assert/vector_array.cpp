@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "vector_array.hpp"
+
+using std::cout;
+using std::endl;
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point begin)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+const char *level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2: return "avx2";
+    case SimdLevel::SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// the same work done one Vector at a time
+void bench_objects(std::vector<Vector> &a, std::vector<Vector> &b, std::vector<double> &out, int rounds)
+{
+    auto begin = Clock::now();
+    double total = 0;
+    for (int round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < a.size(); i++)
+            a[i] = a[i] + b[i];
+        for (size_t i = 0; i < a.size(); i++)
+            out[i] = a[i] * b[i];
+        for (size_t i = 0; i < a.size(); i++)
+            out[i] = (double)a[i];
+        for (size_t i = 0; i < a.size(); i++)
+            total += out[i];
+    }
+    cout << "Vector objects: " << ms_since(begin) << " ms, checksum " << total << endl;
+}
+
+void bench_array(SimdLevel level, VectorArray a, const VectorArray &b, std::vector<double> &out, int rounds)
+{
+    set_simd_level(level);
+    auto begin = Clock::now();
+    double total = 0;
+    for (int round = 0; round < rounds; round++)
+    {
+        a.add_all(b);
+        a.cross_all(b, out.data());
+        a.norm_all(out.data());
+        total += vector_kernels().sum(out.data(), out.size());
+    }
+    cout << "VectorArray " << level_name(level) << ": " << ms_since(begin) << " ms, checksum " << total << endl;
+}
+
+int main()
+{
+    cout << "detected: " << level_name(detect_simd()) << endl;
+
+    VectorArray small;
+    small.push_back(Vector(3, 4));
+    small.push_back(Vector(0, 1));
+    small.push_back(Vector(0, 0));
+    small.push_back(Vector(-6, 8));
+    small.push_back(Vector(1, 1));
+
+    cout << "sum:" << endl << small.sum();
+    cout << "min norm: " << small.min_norm() << ", max norm: " << small.max_norm() << endl;
+    double norms[5];
+    small.norm_all(norms);
+    cout << "norms:";
+    for (double d : norms)
+        cout << " " << d;
+    cout << endl;
+    small.normalize_all();
+    cout << "normalized #0:" << endl << small[0];
+    cout << "normalized #2 (zero stays zero):" << endl << small[2];
+
+    // every level must give the scalar results
+    const size_t n = 1000003; // not a multiple of 4, so the tails run too
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-10, 10);
+    VectorArray a, b;
+    std::vector<Vector> va, vb;
+    for (size_t i = 0; i < n; i++)
+    {
+        Vector u(dist(gen), dist(gen)), v(dist(gen), dist(gen));
+        a.push_back(u);
+        b.push_back(v);
+        va.push_back(u);
+        vb.push_back(v);
+    }
+
+    std::vector<double> expected(n), got(n);
+    set_simd_level(SimdLevel::Scalar);
+    VectorArray reference = a;
+    reference.add_all(b);
+    reference.normalize_all();
+    reference.cross_all(b, expected.data());
+    for (SimdLevel level : {SimdLevel::SSE2, SimdLevel::AVX2})
+    {
+        set_simd_level(level);
+        VectorArray copy = a;
+        copy.add_all(b);
+        copy.normalize_all();
+        copy.cross_all(b, got.data());
+        size_t wrong = 0;
+        for (size_t i = 0; i < n; i++)
+            if (got[i] != expected[i])
+                wrong++;
+        double sum_diff = std::fabs(copy.sum().x() - reference.sum().x());
+        cout << level_name(level) << " vs scalar: " << wrong << " different results, sum differs by " << sum_diff
+             << ", max norm " << copy.max_norm() << " / " << reference.max_norm() << endl;
+    }
+
+    cout << "add + cross + norm + sum over " << n << " vectors x 50 rounds" << endl;
+    bench_objects(va, vb, got, 50);
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2})
+        bench_array(level, a, b, got, 50);
+
+    return 0;
+}
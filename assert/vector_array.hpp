@@ -0,0 +1,476 @@
+#ifndef VECTOR_ARRAY_H_
+#define VECTOR_ARRAY_H_
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "vector.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_ARRAY_X86 1
+#include <immintrin.h>
+// lets one function use AVX2 while the rest of the file is built for the baseline
+#define VECTOR_ARRAY_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Kernels VectorArray runs on its raw arrays.
+// There is a scalar, an SSE2 and an AVX2 version of each. The best one the
+// CPU supports is picked the first time they are used. Every SIMD loop
+// finishes the last few elements with the scalar version.
+enum class SimdLevel
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+struct VectorKernels
+{
+    void (*add)(const double *a, const double *b, double *out, size_t n);
+    void (*scale)(const double *a, double k, double *out, size_t n);
+    void (*cross)(const double *ax, const double *ay, const double *bx, const double *by, double *out, size_t n);
+    void (*norm)(const double *x, const double *y, double *out, size_t n);
+    // a zero vector stays zero
+    void (*normalize)(double *x, double *y, size_t n);
+    double (*sum)(const double *a, size_t n);
+    // smallest and largest x * x + y * y, n must not be 0
+    void (*norm_sq_range)(const double *x, const double *y, size_t n, double *min_sq, double *max_sq);
+};
+
+namespace scalar_kernels
+{
+inline void add(const double *a, const double *b, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = a[i] + b[i];
+}
+
+inline void scale(const double *a, double k, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = a[i] * k;
+}
+
+inline void cross(const double *ax, const double *ay, const double *bx, const double *by, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = ax[i] * by[i] - ay[i] * bx[i];
+}
+
+inline void norm(const double *x, const double *y, double *out, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        out[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+}
+
+inline void normalize(double *x, double *y, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        double len = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+        if (len > 0)
+        {
+            x[i] /= len;
+            y[i] /= len;
+        }
+    }
+}
+
+inline double sum(const double *a, size_t n)
+{
+    double total = 0;
+    for (size_t i = 0; i < n; i++)
+        total += a[i];
+    return total;
+}
+
+inline void norm_sq_range(const double *x, const double *y, size_t n, double *min_sq, double *max_sq)
+{
+    double lo = std::numeric_limits<double>::infinity(), hi = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        double sq = x[i] * x[i] + y[i] * y[i];
+        lo = sq < lo ? sq : lo;
+        hi = sq > hi ? sq : hi;
+    }
+    *min_sq = lo;
+    *max_sq = hi;
+}
+}
+
+#if defined(VECTOR_ARRAY_X86) && defined(__SSE2__)
+// SSE2 is part of every x86-64 CPU, so these need no check
+namespace sse2_kernels
+{
+inline void add(const double *a, const double *b, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    scalar_kernels::add(a + i, b + i, out + i, n - i);
+}
+
+inline void scale(const double *a, double k, double *out, size_t n)
+{
+    __m128d factor = _mm_set1_pd(k);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), factor));
+    scalar_kernels::scale(a + i, k, out + i, n - i);
+}
+
+inline void cross(const double *ax, const double *ay, const double *bx, const double *by, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d l = _mm_mul_pd(_mm_loadu_pd(ax + i), _mm_loadu_pd(by + i));
+        __m128d r = _mm_mul_pd(_mm_loadu_pd(ay + i), _mm_loadu_pd(bx + i));
+        _mm_storeu_pd(out + i, _mm_sub_pd(l, r));
+    }
+    scalar_kernels::cross(ax + i, ay + i, bx + i, by + i, out + i, n - i);
+}
+
+inline __m128d norm_sq(__m128d x, __m128d y)
+{
+    return _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y));
+}
+
+inline void norm(const double *x, const double *y, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(norm_sq(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i))));
+    scalar_kernels::norm(x + i, y + i, out + i, n - i);
+}
+
+inline void normalize(double *x, double *y, size_t n)
+{
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i);
+        __m128d len = _mm_sqrt_pd(norm_sq(vx, vy));
+        __m128d nonzero = _mm_cmpgt_pd(len, _mm_setzero_pd());
+        // 0 / 0 gives NaN, the mask keeps the old zero instead
+        _mm_storeu_pd(x + i, _mm_or_pd(_mm_and_pd(nonzero, _mm_div_pd(vx, len)), _mm_andnot_pd(nonzero, vx)));
+        _mm_storeu_pd(y + i, _mm_or_pd(_mm_and_pd(nonzero, _mm_div_pd(vy, len)), _mm_andnot_pd(nonzero, vy)));
+    }
+    scalar_kernels::normalize(x + i, y + i, n - i);
+}
+
+inline double sum(const double *a, size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd(); // two chains hide the add latency
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+        acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+    return lanes[0] + lanes[1] + scalar_kernels::sum(a + i, n - i);
+}
+
+inline void norm_sq_range(const double *x, const double *y, size_t n, double *min_sq, double *max_sq)
+{
+    __m128d lo = _mm_set1_pd(std::numeric_limits<double>::infinity()), hi = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d sq = norm_sq(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i));
+        lo = _mm_min_pd(lo, sq);
+        hi = _mm_max_pd(hi, sq);
+    }
+    double los[2], his[2];
+    _mm_storeu_pd(los, lo);
+    _mm_storeu_pd(his, hi);
+    scalar_kernels::norm_sq_range(x + i, y + i, n - i, min_sq, max_sq);
+    *min_sq = std::fmin(*min_sq, std::fmin(los[0], los[1]));
+    *max_sq = std::fmax(*max_sq, std::fmax(his[0], his[1]));
+}
+}
+#endif
+
+#ifdef VECTOR_ARRAY_X86
+namespace avx2_kernels
+{
+VECTOR_ARRAY_AVX2 inline void add(const double *a, const double *b, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    scalar_kernels::add(a + i, b + i, out + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline void scale(const double *a, double k, double *out, size_t n)
+{
+    __m256d factor = _mm256_set1_pd(k);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), factor));
+    scalar_kernels::scale(a + i, k, out + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline void cross(const double *ax, const double *ay, const double *bx, const double *by, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d l = _mm256_mul_pd(_mm256_loadu_pd(ax + i), _mm256_loadu_pd(by + i));
+        __m256d r = _mm256_mul_pd(_mm256_loadu_pd(ay + i), _mm256_loadu_pd(bx + i));
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(l, r));
+    }
+    scalar_kernels::cross(ax + i, ay + i, bx + i, by + i, out + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline __m256d norm_sq(__m256d x, __m256d y)
+{
+    return _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+}
+
+VECTOR_ARRAY_AVX2 inline void norm(const double *x, const double *y, double *out, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(norm_sq(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i))));
+    scalar_kernels::norm(x + i, y + i, out + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline void normalize(double *x, double *y, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d vx = _mm256_loadu_pd(x + i), vy = _mm256_loadu_pd(y + i);
+        __m256d len = _mm256_sqrt_pd(norm_sq(vx, vy));
+        __m256d nonzero = _mm256_cmp_pd(len, _mm256_setzero_pd(), _CMP_GT_OQ);
+        _mm256_storeu_pd(x + i, _mm256_blendv_pd(vx, _mm256_div_pd(vx, len), nonzero));
+        _mm256_storeu_pd(y + i, _mm256_blendv_pd(vy, _mm256_div_pd(vy, len), nonzero));
+    }
+    scalar_kernels::normalize(x + i, y + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline double sum(const double *a, size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalar_kernels::sum(a + i, n - i);
+}
+
+VECTOR_ARRAY_AVX2 inline void norm_sq_range(const double *x, const double *y, size_t n, double *min_sq, double *max_sq)
+{
+    __m256d lo = _mm256_set1_pd(std::numeric_limits<double>::infinity()), hi = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d sq = norm_sq(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+        lo = _mm256_min_pd(lo, sq);
+        hi = _mm256_max_pd(hi, sq);
+    }
+    double los[4], his[4];
+    _mm256_storeu_pd(los, lo);
+    _mm256_storeu_pd(his, hi);
+    scalar_kernels::norm_sq_range(x + i, y + i, n - i, min_sq, max_sq);
+    for (int k = 0; k < 4; k++)
+    {
+        *min_sq = std::fmin(*min_sq, los[k]);
+        *max_sq = std::fmax(*max_sq, his[k]);
+    }
+}
+}
+#endif
+
+// best level this CPU can run
+inline SimdLevel detect_simd()
+{
+#ifdef VECTOR_ARRAY_X86
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+#ifdef __SSE2__
+    return SimdLevel::SSE2;
+#endif
+#endif
+    return SimdLevel::Scalar;
+}
+
+inline VectorKernels kernels_for(SimdLevel level)
+{
+    switch (level)
+    {
+#ifdef VECTOR_ARRAY_X86
+    case SimdLevel::AVX2:
+        return VectorKernels{avx2_kernels::add, avx2_kernels::scale, avx2_kernels::cross, avx2_kernels::norm,
+                             avx2_kernels::normalize, avx2_kernels::sum, avx2_kernels::norm_sq_range};
+#ifdef __SSE2__
+    case SimdLevel::SSE2:
+        return VectorKernels{sse2_kernels::add, sse2_kernels::scale, sse2_kernels::cross, sse2_kernels::norm,
+                             sse2_kernels::normalize, sse2_kernels::sum, sse2_kernels::norm_sq_range};
+#endif
+#endif
+    default:
+        return VectorKernels{scalar_kernels::add, scalar_kernels::scale, scalar_kernels::cross, scalar_kernels::norm,
+                             scalar_kernels::normalize, scalar_kernels::sum, scalar_kernels::norm_sq_range};
+    }
+}
+
+// the kernels VectorArray uses, chosen on first use
+inline VectorKernels &vector_kernels()
+{
+    static VectorKernels kernels = kernels_for(detect_simd());
+    return kernels;
+}
+
+// use a lower level, e.g. to compare them; asking for more than the CPU has gets what it has.
+// Not thread safe, call it before starting threads that use VectorArray.
+inline void set_simd_level(SimdLevel level)
+{
+    if (static_cast<int>(level) > static_cast<int>(detect_simd()))
+        level = detect_simd();
+    vector_kernels() = kernels_for(level);
+}
+
+// Structure-of-arrays container of 2-D vectors.
+// All x components are in one array and all y components in another, so
+// each operation below runs as one SIMD loop over the whole array instead of
+// one Vector call per element.
+class VectorArray
+{
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+
+    void check_size(const VectorArray &other) const
+    {
+        if (other.size() != size())
+            abort();
+    }
+
+public:
+    VectorArray() = default;
+    explicit VectorArray(size_t n) : x_(n), y_(n) {}
+
+    size_t size() const { return x_.size(); }
+    void reserve(size_t n);
+    void resize(size_t n);
+    void clear();
+
+    void push_back(const Vector &vec);
+    Vector operator[](size_t i) const { return Vector(x_[i], y_[i]); }
+    void set(size_t i, const Vector &vec);
+
+    // elementwise, other must have the same size
+    void add_all(const VectorArray &other);
+    void scale_all(double lambda);
+    void normalize_all();
+    // out must have room for size() results
+    void cross_all(const VectorArray &other, double *out) const;
+    void norm_all(double *out) const;
+
+    Vector sum() const;
+    // 0 for an empty array
+    double min_norm() const;
+    double max_norm() const;
+
+    double *x_data() { return x_.data(); }
+    double *y_data() { return y_.data(); }
+    const double *x_data() const { return x_.data(); }
+    const double *y_data() const { return y_.data(); }
+};
+
+inline void VectorArray::reserve(size_t n)
+{
+    x_.reserve(n);
+    y_.reserve(n);
+}
+
+inline void VectorArray::resize(size_t n)
+{
+    x_.resize(n);
+    y_.resize(n);
+}
+
+inline void VectorArray::clear()
+{
+    x_.clear();
+    y_.clear();
+}
+
+inline void VectorArray::push_back(const Vector &vec)
+{
+    x_.push_back(vec.x());
+    y_.push_back(vec.y());
+}
+
+inline void VectorArray::set(size_t i, const Vector &vec)
+{
+    x_[i] = vec.x();
+    y_[i] = vec.y();
+}
+
+inline void VectorArray::add_all(const VectorArray &other)
+{
+    check_size(other);
+    vector_kernels().add(x_.data(), other.x_.data(), x_.data(), size());
+    vector_kernels().add(y_.data(), other.y_.data(), y_.data(), size());
+}
+
+inline void VectorArray::scale_all(double lambda)
+{
+    vector_kernels().scale(x_.data(), lambda, x_.data(), size());
+    vector_kernels().scale(y_.data(), lambda, y_.data(), size());
+}
+
+inline void VectorArray::normalize_all()
+{
+    vector_kernels().normalize(x_.data(), y_.data(), size());
+}
+
+inline void VectorArray::cross_all(const VectorArray &other, double *out) const
+{
+    check_size(other);
+    vector_kernels().cross(x_.data(), y_.data(), other.x_.data(), other.y_.data(), out, size());
+}
+
+inline void VectorArray::norm_all(double *out) const
+{
+    vector_kernels().norm(x_.data(), y_.data(), out, size());
+}
+
+inline Vector VectorArray::sum() const
+{
+    return Vector(vector_kernels().sum(x_.data(), size()), vector_kernels().sum(y_.data(), size()));
+}
+
+inline double VectorArray::min_norm() const
+{
+    if (size() == 0)
+        return 0;
+    double lo, hi;
+    vector_kernels().norm_sq_range(x_.data(), y_.data(), size(), &lo, &hi);
+    return std::sqrt(lo);
+}
+
+inline double VectorArray::max_norm() const
+{
+    if (size() == 0)
+        return 0;
+    double lo, hi;
+    vector_kernels().norm_sq_range(x_.data(), y_.data(), size(), &lo, &hi);
+    return std::sqrt(hi);
+}
+
+#undef VECTOR_ARRAY_AVX2
+#undef VECTOR_ARRAY_X86
+
+#endif
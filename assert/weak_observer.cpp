@@ -0,0 +1,35 @@
+#include <memory>
+#include <iostream>
+
+#include "weak_observer.hpp"
+
+using namespace std;
+
+void observe(weak_observer<int> &obs)
+{
+    if (!obs.observe([](int &value) { cout << "observe() able to see the object, value = " << value << endl; }))
+        cout << "observe() unable to see the object" << endl;
+}
+
+int main()
+{
+    weak_observer<int> obs;
+    cout << "observer not yet init" << endl;
+    observe(obs);
+
+    {
+        auto shared = make_shared<int>(12);
+        obs.reset(shared);
+        cout << "observer inited with shared_ptr" << endl;
+        observe(obs);
+        cout << "use count with the observer pinning it: " << shared.use_count() << endl;
+    }
+
+    cout << "shared_ptr has been destructed due to out of scope" << endl;
+    cout << "same epoch, the observer still pins the object" << endl;
+    observe(obs);
+
+    observer_epoch().advance();
+    cout << "new epoch, the observer locks again" << endl;
+    observe(obs);
+}
@@ -0,0 +1,112 @@
+#ifndef WEAK_OBSERVER_H_
+#define WEAK_OBSERVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// weak_ptr.cpp's observe() copies the weak_ptr and locks it on every call,
+// two or three atomic read-modify-writes on the control block each time,
+// and all threads observing the same object fight over that cache line.
+//
+// A weak_observer locks once and keeps the shared_ptr it got until the
+// epoch changes. Observations in between only compare the epoch with the one
+// seen at the lock, a plain load. The owner side decides when an epoch ends:
+//     weak_observer<int> obs(weak);        // one per thread, not shared
+//     obs.observe([](int &v) { ... });     // locks on the first call of an epoch only
+//     shared.reset();
+//     observer_epoch().advance();          // observers let go on their next call
+// The price is that an object may outlive its last shared_ptr until every
+// observer holding it has made a call in the new epoch (or called drop()).
+// Advance after releasing objects, or on a regular tick, e.g. once per frame.
+
+class ObserverEpoch
+{
+private:
+    std::atomic<uint64_t> epoch_{0};
+
+public:
+    uint64_t current() const noexcept { return epoch_.load(std::memory_order_acquire); }
+    void advance() noexcept { epoch_.fetch_add(1, std::memory_order_acq_rel); }
+};
+
+// the epoch observers use unless given another one
+inline ObserverEpoch &observer_epoch()
+{
+    static ObserverEpoch epoch;
+    return epoch;
+}
+
+template <class T>
+class weak_observer
+{
+private:
+    std::weak_ptr<T> weak_;
+    std::shared_ptr<T> pinned_;
+    ObserverEpoch *epoch_;
+    uint64_t seen_ = 0;
+    bool valid_ = false; // pinned_ was locked in epoch seen_
+
+    void refresh()
+    {
+        uint64_t now = epoch_->current();
+        if (valid_ && now == seen_)
+            return;
+        pinned_.reset(); // our own pin would keep the object alive through the lock
+        pinned_ = weak_.lock();
+        seen_ = now;
+        valid_ = true;
+    }
+
+public:
+    weak_observer() : epoch_(&observer_epoch()) {}
+    explicit weak_observer(std::weak_ptr<T> weak, ObserverEpoch &epoch = observer_epoch())
+        : weak_(std::move(weak)), epoch_(&epoch) {}
+    explicit weak_observer(const std::shared_ptr<T> &shared, ObserverEpoch &epoch = observer_epoch())
+        : weak_(shared), epoch_(&epoch) {}
+
+    // observe another object
+    void reset(std::weak_ptr<T> weak)
+    {
+        weak_ = std::move(weak);
+        drop();
+    }
+
+    // let go of the object now instead of at the next epoch
+    void drop() noexcept
+    {
+        pinned_.reset();
+        valid_ = false;
+    }
+
+    // the object, or nullptr if it was gone when this epoch's lock was taken
+    T *get()
+    {
+        refresh();
+        return pinned_.get();
+    }
+
+    // the shared_ptr held for this epoch, for callers that need to keep the object
+    const std::shared_ptr<T> &pin()
+    {
+        refresh();
+        return pinned_;
+    }
+
+    // calls f(object) if there is one; returns whether it was called
+    template <class F>
+    bool observe(F &&f)
+    {
+        if (T *p = get())
+        {
+            std::forward<F>(f)(*p);
+            return true;
+        }
+        return false;
+    }
+
+    bool expired() { return get() == nullptr; }
+};
+
+#endif
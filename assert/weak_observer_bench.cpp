@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "weak_observer.hpp"
+
+using namespace std;
+
+// observe() from weak_ptr.cpp: weak_ptr by value, lock on every call
+__attribute__((noinline)) long observe_copy(weak_ptr<int> weak)
+{
+    if (auto obs = weak.lock())
+        return *obs;
+    return 0;
+}
+
+// the same without the copy
+__attribute__((noinline)) long observe_ref(const weak_ptr<int> &weak)
+{
+    if (auto obs = weak.lock())
+        return *obs;
+    return 0;
+}
+
+__attribute__((noinline)) long observe_cached(weak_observer<int> &obs)
+{
+    int *p = obs.get();
+    return p ? *p : 0;
+}
+
+const long observations = 20000000;
+
+// each thread observes the same object; a ticker thread ends an epoch every millisecond
+template <class Observe>
+void run(const char *name, int threads, Observe observe)
+{
+    auto shared = make_shared<int>(1);
+    weak_ptr<int> weak = shared;
+    atomic<bool> stop{false};
+    thread ticker([&] {
+        while (!stop.load(memory_order_relaxed))
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            observer_epoch().advance();
+        }
+    });
+
+    vector<long> sums(threads * 16);
+    auto begin = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&, t] { sums[t * 16] = observe(weak, observations / threads); });
+    for (thread &w : workers)
+        w.join();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count();
+    stop = true;
+    ticker.join();
+
+    long sum = 0;
+    for (int t = 0; t < threads; t++)
+        sum += sums[t * 16];
+    cout << name << ": " << ns / observations << " ns per observation (" << sum << ")" << endl;
+}
+
+int main()
+{
+    int threads = max(2u, thread::hardware_concurrency());
+    for (int n : {1, threads})
+    {
+        cout << n << " thread(s), " << observations << " observations in all" << endl;
+        run("weak_ptr by value + lock", n, [](const weak_ptr<int> &weak, long count) {
+            long sum = 0;
+            for (long i = 0; i < count; i++)
+                sum += observe_copy(weak);
+            return sum;
+        });
+        run("weak_ptr by ref + lock  ", n, [](const weak_ptr<int> &weak, long count) {
+            long sum = 0;
+            for (long i = 0; i < count; i++)
+                sum += observe_ref(weak);
+            return sum;
+        });
+        run("weak_observer           ", n, [](const weak_ptr<int> &weak, long count) {
+            weak_observer<int> obs(weak);
+            long sum = 0;
+            for (long i = 0; i < count; i++)
+                sum += observe_cached(obs);
+            return sum;
+        });
+    }
+    return 0;
+}